@@ -25,7 +25,9 @@ Abstract_Mark_Sweep_Collector::Abstract_Mark_Sweep_Collector() {
 }
 
 
-void Abstract_Mark_Sweep_Collector::gc() {
+// Logs the GC in the shared GC_Log, only once every other core has stopped; the pause counts
+// from requested_usecs, so it includes getting the safepoint.
+void Abstract_Mark_Sweep_Collector::gc(const char* why, u_int64 requested_usecs) {
   int rank_on_threads_or_zero_on_processes = Memory_Semantics::rank_on_threads_or_zero_on_processes();
 
   if (Trace_Execution  &&  The_Squeak_Interpreter()->execution_tracer() != NULL)
@@ -33,8 +35,13 @@ void Abstract_Mark_Sweep_Collector::gc() {
   if (Trace_GC_For_Debugging  &&  The_Squeak_Interpreter()->debugging_tracer() != NULL)
     The_Squeak_Interpreter()->debugging_tracer()->record_gc();
 
+  Timeline_Slice ts(Timeline::gc, "gc");
+  Hardware_Counters_Phase hp(Hardware_Counters::gc);
   Safepoint_for_moving_objects sf("gc");
   Safepoint_Ability sa(false);
+  GC_Log* const log = The_Memory_System()->gc_log();
+  log->begin(why, requested_usecs);
+  log->lap(GC_Log::safepoint);
   
   // Relies on implicit init to false below:
   static bool recursing[Memory_Semantics::max_num_threads_on_threads_or_1_on_processes]; // threadsafe, GC are started concurrently on multiple cores as far as I can see, Stefan 2009-09-05
@@ -44,9 +51,19 @@ void Abstract_Mark_Sweep_Collector::gc() {
 
   assert(The_Squeak_Interpreter()->safepoint_tracker->have_acquired_safepoint());
   flushFreeContextsMessage_class().send_to_all_cores();
-  prepare(true);
+  log->lap(GC_Log::flush_contexts);
+  {
+    Timeline_Slice ts(Timeline::gc, "prepare");
+    prepare(true);
+  }
+  log->lap(GC_Log::prepare);
   do_it();
-  finish();
+  {
+    Timeline_Slice ts(Timeline::gc, "finish");
+    finish();
+  }
+  log->lap(GC_Log::finish);
+  log->end();
 
   recursing[rank_on_threads_or_zero_on_processes] = false;
 }
@@ -68,15 +85,28 @@ void Abstract_Mark_Sweep_Collector::prepare(bool verify) {
 
 
 void Abstract_Mark_Sweep_Collector::do_it() {
+  GC_Log* const log = The_Memory_System()->gc_log();
   if (print_gc)
     lprintf("finished preparing; about to mark\n");
-  mark();
+  {
+    Timeline_Slice ts(Timeline::gc, "mark");
+    mark();
+  }
+  log->lap(GC_Log::mark);
   if (check_assertions)
     The_Memory_System()->object_table->verify_after_mark();
   if (print_gc)
     lprintf("finished marking, starting sweeping\n");
-  finalize_weak_arrays();
-  sweep_unmark_and_compact_or_free(this);
+  {
+    Timeline_Slice ts(Timeline::gc, "finalize");
+    finalize_weak_arrays();
+  }
+  log->lap(GC_Log::finalize);
+  {
+    Timeline_Slice ts(Timeline::gc, "sweep");
+    sweep_unmark_and_compact_or_free(this);
+  }
+  log->lap(GC_Log::sweep);
 }
 
 
@@ -89,6 +119,10 @@ void Abstract_Mark_Sweep_Collector::finalize_weak_arrays() {
 
 
 void Abstract_Mark_Sweep_Collector::finish() {
+  if (The_Squeak_Interpreter()->run_queues != NULL) {
+    The_Squeak_Interpreter()->run_queues->forget_all_hints();
+    The_Squeak_Interpreter()->run_queues->forget_dead_processes();
+  }
   The_Squeak_Interpreter()->postGCAction_everywhere(true);
 
   The_Memory_System()->verify_if(check_many_assertions);
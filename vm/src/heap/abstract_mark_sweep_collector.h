@@ -18,7 +18,7 @@ public:
 
   Abstract_Mark_Sweep_Collector();
 
-  void gc();
+  void gc(const char* why, u_int64 requested_usecs);
 
   void mark_only_for_debugging();
 
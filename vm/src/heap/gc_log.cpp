@@ -0,0 +1,143 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+#include "headers.h"
+
+char* GC_Log::file_name = NULL;
+
+
+GC_Log* GC_Log::create() {
+  return (GC_Log*)Memory_Semantics::shared_calloc(1, sizeof(GC_Log));
+}
+
+
+u_int64 GC_Log::now_usecs() {
+  return monotonic_nsecs() / 1000;
+}
+
+
+u_int32 GC_Log::object_table_entries_used() {
+  u_int32 used = 0;
+# if Use_Object_Table
+  FOR_ALL_RANKS(r)
+    used += The_Memory_System()->object_table->allocated_entry_count(r);
+# endif
+  return used;
+}
+
+
+// Called once the safepoint is held; the pause counts from when it was requested.
+void GC_Log::begin(const char* w, u_int64 requested_usecs) {
+  Memory_System* const ms = The_Memory_System();
+  why = w;
+  number = ms->get_gcCount() + 1;
+  bzero(phase_usecs, sizeof(phase_usecs));
+  bzero(sweep_usecs, sizeof(sweep_usecs));
+  FOR_ALL_RANKS(r)
+    for (int m = 0;  m < Memory_System::max_num_mutabilities;  ++m)
+      bytes_before[r][m] = ms->heaps[r][m]->bytesUsed();
+  entries_before = object_table_entries_used();
+  start_usecs = lap_usecs = requested_usecs;
+  in_progress = true;
+}
+
+
+int GC_Log::bucket_for(u_int32 pause_usecs) {
+  int b = 0;
+  for (u_int32 ms = pause_usecs / 1000;  ms > 0  &&  b < histogram_size - 1;  ms >>= 1)
+    ++b;
+  return b;
+}
+
+
+void GC_Log::end() {
+  if (!in_progress)
+    return;
+  in_progress = false;
+  u_int32 pause_usecs = now_usecs() - start_usecs;
+  ++pause_histogram[bucket_for(pause_usecs)];
+  write_record(pause_usecs);
+
+  if (file_name == NULL)
+    return;
+  static FILE* f = NULL; // only the core doing the GC writes
+  if (f == NULL  &&  (f = fopen(file_name, "a")) == NULL) {
+    perror("gc log file");
+    file_name = NULL;
+    return;
+  }
+  fprintf(f, "%s\n", last_record);
+  fflush(f);
+}
+
+
+static void append(char* buf, int* used, int size, const char* fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf + *used, size - *used, fmt, ap);
+  va_end(ap);
+  *used = min(size - 1, *used + n);
+}
+
+
+void GC_Log::write_record(u_int32 pause_usecs) {
+  Memory_System* const ms = The_Memory_System();
+  static const char* mutability_names[] = { "read_mostly", "read_write" };
+  char* b = last_record;
+  int n = 0;
+  const int size = sizeof(last_record);
+
+  append(b, &n, size, "{\"gc\": %u, \"reason\": \"%s\", \"pause_us\": %u, \"phases_us\": {", number, why, pause_usecs);
+  const char* sep = "";
+# define APPEND_PHASE(name) \
+  append(b, &n, size, "%s\"%s\": %u", sep, #name, phase_usecs[name]);  sep = ", ";
+  FOR_ALL_GC_PHASES_DO(APPEND_PHASE)
+# undef APPEND_PHASE
+
+  append(b, &n, size, "}, \"sweep_us\": [");
+  FOR_ALL_RANKS(r)
+    append(b, &n, size, "%s%u", r ? ", " : "", sweep_usecs[r]);
+
+  append(b, &n, size, "], \"heaps\": [");
+  FOR_ALL_RANKS(r) {
+    append(b, &n, size, "%s{\"rank\": %d", r ? ", " : "", r);
+    for (int m = 0;  m < Memory_System::max_num_mutabilities;  ++m)
+      append(b, &n, size, ", \"%s\": [%u, %u]", mutability_names[m], bytes_before[r][m], ms->heaps[r][m]->bytesUsed());
+    append(b, &n, size, "}");
+  }
+
+  u_int32 entries = 0;
+# if Use_Object_Table
+  FOR_ALL_RANKS(r)
+    entries += ms->object_table->entry_count(r);
+# endif
+  append(b, &n, size, "], \"object_table\": {\"used_before\": %u, \"used_after\": %u, \"entries\": %u}",
+         entries_before, object_table_entries_used(), entries);
+
+  append(b, &n, size, ", \"pause_histogram_ms\": [");
+  for (int i = 0;  i < histogram_size;  ++i)
+    append(b, &n, size, "%s%u", i ? ", " : "", pause_histogram[i]);
+  append(b, &n, size, "]}");
+}
+
+
+// The counts of pauses under 1ms, under 2ms, under 4ms, ..., and the rest.
+Oop GC_Log::get_pause_histogram() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  int s = interp->makeArrayStart();
+  for (int i = 0;  i < histogram_size;  ++i)
+    PUSH_POSITIVE_32_BIT_INT_FOR_MAKE_ARRAY(pause_histogram[i]);
+  return interp->makeArray(s);
+}
+
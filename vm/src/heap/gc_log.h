@@ -0,0 +1,78 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// A record of every full GC, kept whether or not anyone asks: why it ran, how long each phase
+// took (the sweep per core), the bytes used in each heap before and after, object table
+// occupancy, and a histogram of all pauses so far. Each GC is written as one JSON line
+// to the file given with -gc_log, and the last one can be read with primitiveVMParameter.
+// The collector laps the log at the end of each phase, charging the time since the last lap.
+// Only the core doing the GC writes, under its safepoint, except for each core's sweep time.
+// Leveling out the heaps afterwards is a pause of its own, with its own safepoint, so not in the record.
+// Times come from monotonic_nsecs, so a step of the wall clock cannot wrap a pause.
+// Shared. -- see Memory_System::global_GC_values
+
+class GC_Log {
+public:
+  static char* file_name; // -gc_log
+
+# define FOR_ALL_GC_PHASES_DO(template) \
+  template(safepoint) \
+  template(flush_contexts) \
+  template(prepare) \
+  template(mark) \
+  template(finalize) \
+  template(sweep) \
+  template(finish)
+
+# define DEFINE_GC_PHASE(name) name,
+  enum Phase { FOR_ALL_GC_PHASES_DO(DEFINE_GC_PHASE) phase_count };
+# undef DEFINE_GC_PHASE
+
+  static const int histogram_size = 16; // pauses under 1ms, under 2ms, under 4ms, ..., the rest
+  static const int max_record_size = 4096 + Max_Number_Of_Cores * 96;
+
+private:
+  bool    in_progress;
+  const char* why;
+  u_int32 number;
+  u_int64 start_usecs, lap_usecs;
+  u_int32 phase_usecs[phase_count];
+  u_int32 sweep_usecs[Max_Number_Of_Cores];
+  u_int32 bytes_before[Max_Number_Of_Cores][Memory_System::max_num_mutabilities];
+  u_int32 entries_before;
+  u_int32 pause_histogram[histogram_size];
+  char    last_record[max_record_size]; // JSON, empty before the first GC
+
+  static int bucket_for(u_int32 pause_usecs);
+  void write_record(u_int32 pause_usecs);
+  static u_int32 object_table_entries_used();
+
+public:
+  static GC_Log* create();
+  static u_int64 now_usecs();
+
+  void begin(const char* why, u_int64 requested_usecs);
+  void lap(Phase p) {
+    if (!in_progress)  return;
+    u_int64 now = now_usecs();
+    phase_usecs[p] += now - lap_usecs;
+    lap_usecs = now;
+  }
+  void record_sweep_here(u_int64 began_usecs) { sweep_usecs[Logical_Core::my_rank()] = now_usecs() - began_usecs; }
+  void end();
+
+  const char* get_last_record() { return last_record; }
+  Oop get_pause_histogram();
+};
+
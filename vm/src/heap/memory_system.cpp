@@ -15,6 +15,12 @@
 #include "headers.h"
 
 bool     Memory_System::use_huge_pages = On_Tilera;
+bool     Memory_System::use_numa = false;
+bool     Memory_System::use_transparent_huge_pages = false;
+bool     Memory_System::allow_background_snapshots = false;
+volatile int Memory_System::background_snapshot_pid = 0;
+int      Memory_System::background_snapshot_semaphore_index = 0;
+bool     Memory_System::background_snapshot_succeeded = false;
 bool     Memory_System::replicate_methods = false; // if true methods are put on read-mostly heap
 bool     Memory_System::replicate_all = true; // if true, all (non-contexts) are allowed in read-mostly heap
 bool     Memory_System::OS_mmaps_up = On_Apple;
@@ -42,6 +48,7 @@ Memory_System::Memory_System() {
   global_GC_values->mutator_start_time = 0;
   global_GC_values->last_gc_ms = 0;
   global_GC_values->inter_gc_ms = 0;
+  global_GC_values->gc_log = GC_Log::create();
 
   page_size_used_in_heap = 0;
 
@@ -59,6 +66,23 @@ void Memory_System::finished_adding_objects_from_snapshot() {
   // now all objects are in the heap, so we are also sure that this file is
   // in memory and the filesystem link is not to be used by mmap anymore
   OS_Interface::unlink_heap_file();
+  
+  report_huge_pages_obtained();
+}
+
+
+// Only touched pages can be huge, so this is most telling once the image is in.
+void Memory_System::report_huge_pages_obtained() {
+  if (!use_transparent_huge_pages)
+    return;
+  size_t total = read_write_memory_past_end - read_mostly_memory_base;
+  int64_t kb = OS_Interface::get_huge_page_backed_kb(read_mostly_memory_base, total);
+  if (kb < 0)
+    lprintf("Could not find out how much of the heap is backed by huge pages.\n");
+  else
+    lprintf("%lld MB of %d MB heap backed by transparent huge pages (%lld pages)\n",
+            (long long)kb / 1024, int(total / Mega),
+            (long long)kb * 1024 / OS_Interface::transparent_huge_page_size);
 }
 
 void Memory_System::enforce_coherence_after_each_core_has_stored_into_its_own_heap() {
@@ -139,7 +163,7 @@ void Memory_System::fullGC(const char* why) {
   global_GC_values->gcCycles -= OS_Interface::get_cycle_count();
   
   Mark_Sweep_Collector msc;
-  msc.gc();
+  msc.gc(why, GC_Log::now_usecs());
   
   ++global_GC_values->gcCount;
   global_GC_values->gcMilliseconds += (global_GC_values->last_gc_ms = interp->ioWhicheverMSecs() - last_gc_start);
@@ -508,19 +532,192 @@ void Memory_System::writeImageFileIO(char* image_name) {
     return;
   }
 
-  if (fseek(f, headerSize, SEEK_SET)) {
-    perror("seek");
+  if (fflush(f)) {
+    perror("write of snapshot header");
     The_Squeak_Interpreter()->success(false);
+    fclose(f);
     return;
   }
-  bool is_first_object = true; // see comment in write_image_file
-  FOR_ALL_HEAPS(rank, mutability) {
-    heaps[rank][mutability]->write_image_file(f, heap_offsets, is_first_object /* passed by REF */ );
+  if (!write_snapshot_heaps(fileno(f), heap_offsets, Using_Threads))
+    The_Squeak_Interpreter()->success(false);
+  // one sync for the whole file, rather than relying on fclose
+  else if (fsync(fileno(f))) {
+    perror("fsync of snapshot");
+    The_Squeak_Interpreter()->success(false);
   }
   fclose(f);
   return;
 }
 
+
+// Every heap's place in the file is known up front: it is written as is, except that
+// the very first object loses its preheader (see comment in write_image_file).
+// So with threads each core pwrites its own heaps at the same time; with processes
+// the fd is not shared, and this core writes them all, as does a background snapshot child.
+bool Memory_System::write_snapshot_heaps(int fd, u_int32* heap_offsets, bool in_parallel) {
+  Snapshot_Layout layout;
+  layout.fd = fd;
+  layout.heap_offsets = heap_offsets;
+  layout.first_nonempty_heap = -1;
+  
+  off_t position = headerSize;
+  FOR_ALL_HEAPS(rank, mutability) {
+    int i = &heaps[rank][mutability] - &heaps[0][0];
+    int bytes = heaps[rank][mutability]->bytesUsed();
+    layout.file_positions[i] = position;
+    if (bytes > 0  &&  layout.first_nonempty_heap < 0) {
+      layout.first_nonempty_heap = i;
+      bytes -= preheader_byte_size;
+    }
+    position += bytes;
+  }
+  if (ftruncate(fd, position)) {
+    perror("could not extend snapshot file");
+    return false;
+  }
+  
+  if (!in_parallel) {
+    bool ok = true;
+    FOR_ALL_HEAPS(rank, mutability) {
+      int i = &heaps[rank][mutability] - &heaps[0][0];
+      Snapshot_Writer w(fd, layout.file_positions[i]);
+      heaps[rank][mutability]->write_image_file(w, heap_offsets, i == layout.first_nonempty_heap);
+      ok = w.flush()  &&  ok;
+    }
+    return ok;
+  }
+  
+  FOR_ALL_OTHER_RANKS(r)
+    writeSnapshotHeapsMessage_class(&layout).send_to(r);
+  
+  bool ok = write_my_snapshot_heaps(&layout);
+  
+  FOR_ALL_OTHER_RANKS(r) {
+    writeSnapshotHeapsResponse_class response(&The_Receive_Marker);
+    response.receive_and_handle_messages_returning_a_match(r);
+    ok = response.ok  &&  ok;
+  }
+  return ok;
+}
+
+
+bool Memory_System::write_my_snapshot_heaps(Snapshot_Layout* layout) {
+  const int rank = Logical_Core::my_rank();
+  bool ok = true;
+  for (int mutability = 0;  mutability < max_num_mutabilities;  ++mutability) {
+    int i = &heaps[rank][mutability] - &heaps[0][0];
+    Snapshot_Writer w(layout->fd, layout->file_positions[i]);
+    heaps[rank][mutability]->write_image_file(w, layout->heap_offsets, i == layout->first_nonempty_heap);
+    ok = w.flush()  &&  ok;
+    assert_always(!ok  ||  w.get_position() == layout->file_positions[i] + heaps[rank][mutability]->bytesUsed()
+                                                - (i == layout->first_nonempty_heap ? preheader_byte_size : 0));
+  }
+  return ok;
+}
+
+// Background snapshots: everyone is already at a safepoint with the active context stored.
+// Write the header here (it needs the screen, which the child must not touch),
+// then fork. The child sees the heaps and object table as they are now, copy-on-write,
+// and writes the objects serially to a temporary file it then renames over the image;
+// meanwhile the cores go on running. The main core reaps the child in checkForInterrupts
+// and signals the semaphore. -- see Squeak_Interpreter::background_snapshot
+
+// Only a hint: another core may start one first. claim_background_snapshot decides.
+bool Memory_System::can_start_background_snapshot() {
+  return allow_background_snapshots  &&  Using_Threads  &&  background_snapshot_pid == 0;
+}
+
+
+// The starter claims with a CAS from 0 to -1, and then sets the child's pid
+// (or 0 again if there is none). The main core only clears a positive pid.
+bool Memory_System::claim_background_snapshot() {
+  return allow_background_snapshots  &&  Using_Threads
+     &&  __sync_bool_compare_and_swap(&background_snapshot_pid, 0, -1);
+}
+
+
+// Must hold the claim; gives it up on failure.
+bool Memory_System::fork_to_write_image_file(int semaphore_index) {
+  assert_always(background_snapshot_pid == -1);
+  background_snapshot_semaphore_index = semaphore_index;
+  background_snapshot_succeeded = false;
+
+  static const char suffix[] = ".bgsave";
+  char* image = imageName();
+  char* temp_name = new char[strlen(image) + sizeof(suffix)];
+  strcpy(temp_name, image);
+  strcat(temp_name, suffix);
+
+  FILE* f = fopen(temp_name, "wb");
+  if (f == NULL) {
+    perror("could not open file for background snapshot");
+    delete [] temp_name;
+    background_snapshot_pid = 0;
+    return false;
+  }
+  u_int32 heap_offsets[sizeof(heaps)/sizeof(heaps[0][0])];
+  compute_snapshot_offsets(heap_offsets);
+  write_snapshot_header(f, heap_offsets);
+  if (!The_Squeak_Interpreter()->successFlag  ||  fflush(f)) {
+    perror("write of background snapshot header");
+    fclose(f);
+    unlink(temp_name);
+    delete [] temp_name;
+    background_snapshot_pid = 0;
+    return false;
+  }
+
+  int pid = fork();
+  if (pid == 0) {
+    // Only this thread exists in the child; the others are parked at the safepoint
+    // in the parent, so no heap, table, or allocator lock is held here.
+    bool ok = write_snapshot_heaps(fileno(f), heap_offsets, false);
+    if (ok  &&  fsync(fileno(f))) {
+      perror("fsync of background snapshot");
+      ok = false;
+    }
+    if (ok  &&  rename(temp_name, image)) {
+      perror("rename of background snapshot");
+      ok = false;
+    }
+    if (!ok)  unlink(temp_name);
+    _exit(ok ? 0 : 1);
+  }
+  fclose(f);
+  if (pid < 0) {
+    perror("fork for background snapshot");
+    unlink(temp_name);
+    delete [] temp_name;
+    background_snapshot_pid = 0;
+    return false;
+  }
+  delete [] temp_name;
+  __sync_synchronize(); // semaphore index before pid, for the main core
+  background_snapshot_pid = pid;
+  lprintf("background snapshot: writing in process %d\n", pid);
+  return true;
+}
+
+
+void Memory_System::check_for_finished_background_snapshot() {
+  const int pid = background_snapshot_pid;
+  if (pid <= 0)
+    return;
+  int status;
+  int r = waitpid(pid, &status, WNOHANG);
+  if (r == 0)
+    return;
+  if (r < 0)
+    perror("waitpid for background snapshot");
+  background_snapshot_succeeded = r > 0  &&  WIFEXITED(status)  &&  WEXITSTATUS(status) == 0;
+  const int semaphore_index = background_snapshot_semaphore_index;
+  __sync_synchronize();
+  background_snapshot_pid = 0; // lets the next one start
+  lprintf("background snapshot: %s\n", background_snapshot_succeeded ? "done" : "failed");
+  The_Squeak_Interpreter()->signalSemaphoreWithIndex(semaphore_index);
+}
+
+
 void Memory_System::write_snapshot_header(FILE* f, u_int32* heap_offsets) {
   putLong(The_Squeak_Interpreter()->image_version, f);
   putLong(headerSize, f);
@@ -670,13 +867,27 @@ void Memory_System::initialize_from_snapshot(int32 snapshot_bytes, int32 sws, in
 
 
 void Memory_System::set_page_size_used_in_heap() {
-  if (use_huge_pages) {
+  if (use_transparent_huge_pages  &&  !Using_Threads) {
+    lprintf("Transparent huge pages need an anonymous mapping, which only threads can share.\n");
+    use_transparent_huge_pages = false;
+  }
+  if (allow_background_snapshots  &&  (!Using_Threads  ||  On_Tilera)) {
+    lprintf("Background snapshots need a private heap mapping, which only threads can share.\n");
+    allow_background_snapshots = false;
+  }
+  if (use_transparent_huge_pages) {
+    // The kernel promotes pages by itself; the heap still works in normal pages.
+    use_huge_pages = false;
+    lprintf("Using transparent huge pages.\n");
+  }
+  else if (use_huge_pages) {
     int   co_pages = calculate_total_read_write_pages(huge_page_size);
     int inco_pages = calculate_total_read_mostly_pages(huge_page_size);
     if (!OS_Interface::ask_for_huge_pages(co_pages + inco_pages))
       use_huge_pages = false;
   }
-  lprintf("Using %s pages.\n", use_huge_pages ? "huge" : "normal");
+  if (!use_transparent_huge_pages)
+    lprintf("Using %s pages.\n", use_huge_pages ? "huge" : "normal");
   int hps = huge_page_size,  nps = normal_page_size; // compiler bug, need to alias these
   page_size_used_in_heap = use_huge_pages ? hps : nps;
 }
@@ -728,8 +939,11 @@ void Memory_System::map_heap_memory_in_one_request(int pid,
                                                    size_t grand_total,
                                                    size_t inco_size,
                                                    size_t co_size) {
-  read_mostly_memory_base = OS_Interface::map_heap_memory(grand_total, grand_total,
-                                            NULL, 0, pid, MAP_SHARED);
+  // A background snapshot forks, so it needs a private heap that the child gets copy-on-write.
+  read_mostly_memory_base = use_transparent_huge_pages  ||  allow_background_snapshots
+    ? OS_Interface::map_anonymous_heap_memory(grand_total, use_transparent_huge_pages)
+    : OS_Interface::map_heap_memory(grand_total, grand_total,
+                                    NULL, 0, pid, MAP_SHARED);
   read_mostly_memory_past_end = read_mostly_memory_base + inco_size;
 
   read_write_memory_base      = read_mostly_memory_past_end;
@@ -862,6 +1076,9 @@ void Memory_System::init_values_from_buffer(init_buf* ib) {
 
 void Memory_System::create_my_heaps(init_buf* ib) {
   const int my_rank = Logical_Core::my_rank();
+  
+  if (use_numa)
+    home_my_heaps_to_my_numa_node();
 
   Multicore_Object_Heap* h = new Multicore_Object_Heap();
   h->initialize_multicore( ib->lastHash + my_rank,
@@ -881,6 +1098,27 @@ void Memory_System::create_my_heaps(init_buf* ib) {
 }
 
 
+// Must run on the (already pinned) core owning the heaps, before they are initialized.
+// If the OS will not bind the pages, fall back on first-touch: writing each page from
+// here allocates it on this core's node. (A read would only map the shared zero page.)
+// The memory is fresh and the heap not set up yet, so writing a zero changes nothing.
+void Memory_System::home_my_heaps_to_my_numa_node() {
+  const int my_rank = Logical_Core::my_rank();
+  struct { char* base; size_t size; } parts[max_num_mutabilities];
+  parts[read_write ].base = &read_write_memory_base [memory_per_read_write_heap  * my_rank];
+  parts[read_write ].size = memory_per_read_write_heap;
+  parts[read_mostly].base = &read_mostly_memory_base[memory_per_read_mostly_heap * my_rank];
+  parts[read_mostly].size = memory_per_read_mostly_heap;
+  
+  for (int i = 0;  i < max_num_mutabilities;  ++i) {
+    if (OS_Interface::bind_memory_to_rank(parts[i].base, parts[i].size, my_rank))
+      continue;
+    for (volatile char* p = parts[i].base;  p < parts[i].base + parts[i].size;  p += page_size_used_in_heap)
+      *p = 0;
+  }
+}
+
+
 // three phases (for read-mostly heaps); all machines pre-cohere all heaps, then scan, the all post-cohere
 
 // We used to do each core's heap in parallel, but when we introduced the read-mostly heap
@@ -897,8 +1135,11 @@ void Memory_System::scan_compact_or_make_free_objects_everywhere(bool compacting
 
 
 void Memory_System::scan_compact_or_make_free_objects_here(bool compacting, Abstract_Mark_Sweep_Collector* gc_or_null) {
+  u_int64 start = GC_Log::now_usecs();
   heaps[Logical_Core::my_rank()][read_write ]->scan_compact_or_make_free_objects(compacting, gc_or_null);
   heaps[Logical_Core::my_rank()][read_mostly]->scan_compact_or_make_free_objects(compacting, gc_or_null);
+  if (gc_or_null != NULL)
+    global_GC_values->gc_log->record_sweep_here(start);
 }
 
 
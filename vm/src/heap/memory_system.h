@@ -49,6 +49,8 @@
  * A temporary file is used to ensure that all cores are working on the same
  * memory.
  */
+class GC_Log;
+
 class Memory_System {
 
 private:
@@ -68,6 +70,9 @@ private:
   // huge pages at boot time to use the use_huge_pages flag (hugepages=56)
 public:
   static bool use_huge_pages;   // threadsafe readonly config value
+  static bool use_numa;         // threadsafe readonly config value
+  static bool use_transparent_huge_pages; // threadsafe readonly config value
+  static bool allow_background_snapshots; // threadsafe readonly config value, needs a heap that is copied on fork
   static size_t min_heap_MB;      // threadsafe readonly
   static bool replicate_methods;// threadsafe readonly
   static bool replicate_all;    // threadsafe readonly
@@ -88,6 +93,7 @@ private:
     u_int32 gcCount, gcMilliseconds;
     u_int64 gcCycles;
     u_int32 mutator_start_time, last_gc_ms, inter_gc_ms;
+    GC_Log* gc_log;
   };
   struct global_GC_values* global_GC_values;
 
@@ -178,6 +184,8 @@ public:
   void initialize_helper();
 
   void create_my_heaps(init_buf*);
+  void home_my_heaps_to_my_numa_node();
+  void report_huge_pages_obtained();
   void init_values_from_buffer(init_buf*);
 
 
@@ -275,6 +283,9 @@ public:
   void set_shrinkThreshold(int32 s) { global_GC_values->shrinkThreshold = s; }
   int32 get_growHeadroom() { return global_GC_values->growHeadroom; }
   int32 get_shrinkThreshold() { return global_GC_values->shrinkThreshold; }
+  u_int32 get_gcCount() { return global_GC_values->gcCount; }
+  u_int32 get_gcMilliseconds() { return global_GC_values->gcMilliseconds; }
+  GC_Log* gc_log() { return global_GC_values->gc_log; }
 
   void fullGC(const char*);
   void incrementalGC() {  if (check_assertions) lprintf("no incremental GC\n"); }
@@ -305,13 +316,27 @@ public:
 
   void snapshotCleanUp();
   void writeImageFile(char*);
+
+  // Background snapshots: started by whichever core runs the primitive, reaped by the main core
+  bool can_start_background_snapshot();
+  bool claim_background_snapshot();
+  bool fork_to_write_image_file(int semaphore_index);
+  void check_for_finished_background_snapshot();
+  bool last_background_snapshot_succeeded() { return background_snapshot_succeeded; }
 private:
+  // process-wide, like the heap mapping itself; only used with threads
+  static volatile int background_snapshot_pid; // 0 when none is in progress, -1 while one starts; see claim_background_snapshot
+  static int  background_snapshot_semaphore_index;
+  static bool background_snapshot_succeeded;
+
   void writeImageFileIO(char* image_name);
   void write_snapshot_header(FILE*, u_int32*);
+  bool write_snapshot_heaps(int fd, u_int32*, bool in_parallel);
   int32 max_lastHash();
 
 
 public:
+  bool write_my_snapshot_heaps(Snapshot_Layout*);
 
   void putLong(int32 x, FILE* f);
 
@@ -147,7 +147,8 @@ void Multicore_Object_Heap::snapshotCleanUp() {
 
 
 
-void Multicore_Object_Heap::write_image_file(FILE* f, u_int32* address_offsets, bool& is_first_object) {
+// is_first_object is true only for the first heap in the file that has any objects
+void Multicore_Object_Heap::write_image_file(Snapshot_Writer& w, u_int32* address_offsets, bool is_first_object) {
   
 
   const oop_int_t preheader_placeholder = Object::make_free_object_header(preheader_byte_size);
@@ -166,38 +167,37 @@ void Multicore_Object_Heap::write_image_file(FILE* f, u_int32* address_offsets,
       int bytes = obj->sizeOfFree();
       oop_int_t* p = obj->as_oop_int_p();
       for (int i = 0;  i < bytes;  i += sizeof(int32))
-        The_Memory_System()->putLong(*p++, f);
+        w.putLong(*p++);
       last_obj = obj;
       continue;
     }
 
     assert(sizeof(long) == sizeof(Oop));
     if (preheader_oop_size  &&  !is_first_object /* see long comment above */) { // Squeak 64-bit VM bug workaround
-      The_Memory_System()->putLong(preheader_placeholder, f);
+      w.putLong(preheader_placeholder);
       for (int i = 1;  i  <  preheader_oop_size;  ++i)
-        The_Memory_System()->putLong(Oop::Illegals::free_extra_preheader_words, f);
+        w.putLong(Oop::Illegals::free_extra_preheader_words);
     }
 
     if (obj->contains_sizeHeader())
-      The_Memory_System()->putLong(obj->sizeHeader(), f);
+      w.putLong(obj->sizeHeader());
 
     if (obj->contains_class_and_type_word())
-      The_Memory_System()->putLong(
+      w.putLong(
               Header_Type::extract_from( obj->class_and_type_word() )
-              |  Header_Type::without_type( The_Memory_System()->adjust_for_snapshot(obj->get_class_oop().as_object(), address_offsets) ),
-              f);
-    The_Memory_System()->putLong(obj->baseHeader, f);
+              |  Header_Type::without_type( The_Memory_System()->adjust_for_snapshot(obj->get_class_oop().as_object(), address_offsets) ));
+    w.putLong(obj->baseHeader);
 
     oop_int_t* p;
     for ( p = &obj->baseHeader + 1;
          (Oop*)p <= obj->last_pointer_addr();
          ++p ) {
        Oop oop = *(Oop*)p;
-       The_Memory_System()->putLong( oop.is_int()
+       w.putLong( oop.is_int()
             ? oop.bits()
-            : The_Memory_System()->adjust_for_snapshot(oop.as_object(), address_offsets),  f);
+            : The_Memory_System()->adjust_for_snapshot(oop.as_object(), address_offsets));
     }
-    for (Chunk* next = obj->nextChunk();  p < (oop_int_t*)next;  The_Memory_System()->putLong(*p++, f))
+    for (Chunk* next = obj->nextChunk();  p < (oop_int_t*)next;  w.putLong(*p++))
       ; // bytes
     last_obj = obj;
     
@@ -45,7 +45,7 @@ class Multicore_Object_Heap: public Abstract_Object_Heap {
   Oop next_instance_of_after(Oop, Oop);
 
   void snapshotCleanUp();
-  void write_image_file(FILE*, u_int32*, bool&);
+  void write_image_file(Snapshot_Writer&, u_int32*, bool);
 
   Object_p object_address_unchecked(Oop);
 
@@ -60,7 +60,10 @@ inline Object_p Multicore_Object_Heap::allocate(oop_int_t byteSize, oop_int_t hd
   Object_p newObj = chunk->fill_in_after_allocate(byteSize, hdrSize, baseHeader,
                                                  remappedClassOop, extendedSize, doFill, fillWithNil);
   assert_eq(newObj->nextChunk(), saved_next, "allocate bug: did not set header of new oop correctly");
-  
+
+  if (Allocation_Profiler::sample_bytes > 0)
+    Allocation_Profiler::note_allocation(newObj, total_bytes);
+
 
   return newObj;
 }
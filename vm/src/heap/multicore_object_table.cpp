@@ -67,7 +67,7 @@ void Multicore_Object_Table::restore_from_checkpoint(FILE* f) {
   xfread(&n_segs, sizeof(n_segs), 1, f);
   Segment** segs = (Segment**)alloca(n_segs * sizeof(Segment*));
   for (int i = 0;  i < n_segs;  ++i)
-    segs[i] = new Segment(NULL, -1  COMMA_FALSE_OR_NOTHING);
+    segs[i] = new (-1) Segment(NULL, -1  COMMA_FALSE_OR_NOTHING);
 
   for (int i = 0;  i < n_segs;  ++i)
     Segment::restore_from_checkpoint(f, segs, n_segs);
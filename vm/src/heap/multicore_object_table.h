@@ -40,7 +40,6 @@ public:
     int rank = e->rank();
     e->word()->set_obj_and_spare_bit(NULL, false  COMMA_USE_ESB);
     add_entry_to_free_list(e, rank  COMMA_USE_ESB);
-    --allocatedEntryCount[rank];
     ++entriesFreedSinceLastQuery[rank];
   }
 
@@ -83,11 +83,14 @@ Segmented_Object_Table::Segment::Segment(Object_Table* mot, int rank  COMMA_DCL_
 }
 
 
-void* Segmented_Object_Table::Segment::operator new(size_t /* s */) {
+// rank < 0 means the segment belongs to no core in particular (e.g. restoring a checkpoint)
+void* Segmented_Object_Table::Segment::operator new(size_t /* s */, int rank) {
   void* p = OS_Interface::rvm_memalign_shared(The_Memory_System()->object_table->heap, alignment_and_size, sizeof(Segment));
   assert(sizeof(Segment) <= alignment_and_size);
   if (p == NULL) fatal("OT Segment allocation");
-  // xxxxxx Should home segments appropriately someday.
+  // Home the segment on its core's node before the bzero below touches it.
+  if (Memory_System::use_numa  &&  rank >= 0)
+    OS_Interface::bind_memory_to_rank(p, alignment_and_size, rank);
   if (!The_Squeak_Interpreter()->use_checkpoint()) bzero(p, sizeof(Segment));
   return p;
 }
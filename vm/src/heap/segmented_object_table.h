@@ -81,7 +81,7 @@ protected:
     // parallel arrays to optimize caching, system uses word shift, see bits_for_hash in oop.h
     union word_union words[n];
     
-    void* operator new(size_t);
+    void* operator new(size_t, int rank);
     void operator delete(void *);
     Segment(Object_Table*,int  COMMA_DCL_ESB);
     Entry* construct_free_list();
@@ -161,6 +161,9 @@ protected:
   
 public:
   Segmented_Object_Table();
+
+  u_int32 allocated_entry_count(int rank) const { return allocatedEntryCount[rank]; }
+  u_int32 entry_count(int rank)           const { return entryCount[rank]; }
   
   Object* object_for(Oop x) {
     if (check_many_assertions) check_for_debugging(x);
@@ -172,7 +175,7 @@ public:
   }
   
   
-  inline Oop allocate_OTE_for_object_in_snapshot(Object*);
+  inline Oop allocate_OTE_for_object_in_snapshot(Object*, int rank);
   inline int rank_for_adding_object_from_snapshot(Oop);
 
   
@@ -12,8 +12,7 @@
  ******************************************************************************/
 
 
-inline Oop Segmented_Object_Table::allocate_OTE_for_object_in_snapshot(Object*)  {
-  int rank = The_Memory_System()->assign_rank_for_snapshot_object();
+inline Oop Segmented_Object_Table::allocate_OTE_for_object_in_snapshot(Object*, int rank)  {
   return  allocate_oop(rank COMMA_FALSE_OR_NOTHING);
 }
 
@@ -28,7 +27,7 @@ inline Oop Segmented_Object_Table::allocate_oop(int rank COMMA_DCL_ESB)  {
   Entry*& first_free = first_free_entry[rank];
   Entry* e = first_free;
   if (e == NULL) {
-    new Segment((Object_Table*)this, rank  COMMA_USE_ESB);
+    new (rank) Segment((Object_Table*)this, rank  COMMA_USE_ESB);
     e = first_free;
   }
   __attribute__((unused)) Entry* last_first_free = e; // debugging
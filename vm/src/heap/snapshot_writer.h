@@ -0,0 +1,72 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ * 
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+
+// Buffers the words of one heap and pwrites them at that heap's place in the snapshot file,
+// so that each core can write its own heaps at the same time as the others. -- see Memory_System::write_snapshot_heaps
+
+// Where each heap goes in the snapshot file; shared by all cores while writing.
+class Snapshot_Layout {
+public:
+  int fd;
+  u_int32* heap_offsets;  // see Memory_System::compute_snapshot_offsets
+  off_t file_positions[Max_Number_Of_Cores * 2 /* max_num_mutabilities */];
+  int first_nonempty_heap;
+};
+
+
+class Snapshot_Writer {
+  static const int N = 64 * 1024; // words
+  int32* buf;
+  int next_word;
+  int fd;
+  off_t position;
+  bool ok;
+
+public:
+  Snapshot_Writer(int fd_, off_t pos) {
+    buf = new int32[N];
+    next_word = 0;
+    fd = fd_;
+    position = pos;
+    ok = true;
+  }
+  ~Snapshot_Writer() { flush();  delete [] buf; }
+
+  void putLong(int32 x) {
+    if (next_word == N)  flush();
+    buf[next_word++] = x;
+  }
+
+  bool flush() {
+    const char* p = (const char*)buf;
+    size_t n = next_word * sizeof(int32);
+    next_word = 0;
+    while (ok  &&  n > 0) {
+      ssize_t w = pwrite(fd, p, n, position);
+      if (w < 0) {
+        if (errno == EINTR)  continue;
+        perror("pwrite of snapshot");
+        ok = false;
+        break;
+      }
+      p += w;  n -= w;  position += w;
+    }
+    return ok;
+  }
+
+  bool succeeded() const { return ok; }
+  off_t get_position() const { return position + next_word * sizeof(int32); }
+};
+
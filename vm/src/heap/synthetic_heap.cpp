@@ -0,0 +1,206 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+#include  <vector> // before utils.h defines min and max
+
+#include "headers.h"
+# include <math.h>
+
+char* Synthetic_Heap::spec = NULL;
+
+# define DEFINE_PARAMETER(name, type, default_value, explanation) type Synthetic_Heap::name = default_value;
+FOR_ALL_SYNTHETIC_HEAP_PARAMETERS_DO(DEFINE_PARAMETER)
+# undef DEFINE_PARAMETER
+
+
+// xorshift, so that a seed builds the same heap on every platform
+static u_int32 random_state;
+
+static u_int32 next_random() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+static double random_fraction() { return next_random() / 4294967296.0; }
+static int    random_below(int n) { return int(random_fraction() * n); }
+
+static int log_uniform(int lo, int hi) {
+  return lo - 1 + int(exp(random_fraction() * log(double(hi - lo + 2))));
+}
+
+
+void Synthetic_Heap::usage() {
+  fprintf(stderr, "-synthetic_heap takes name=value,name=value...:\n");
+# define PRINT_PARAMETER(name, type, default_value, explanation) \
+  fprintf(stderr, "\t%-12s %s, default %s\n", #name, explanation, #default_value);
+  FOR_ALL_SYNTHETIC_HEAP_PARAMETERS_DO(PRINT_PARAMETER)
+# undef PRINT_PARAMETER
+  fatal("bad -synthetic_heap");
+}
+
+
+void Synthetic_Heap::parse_spec() {
+  char* s = strdup(spec);
+  char* rest = NULL;
+  for (char* item = strtok_r(s, ",", &rest);  item != NULL;  item = strtok_r(NULL, ",", &rest)) {
+    char* value = strchr(item, '=');
+    if (value == NULL)
+      usage();
+    *value++ = '\0';
+    bool found = false;
+# define PARSE_PARAMETER(name, type, default_value, explanation) \
+    if (strcmp(item, #name) == 0) { name = (type)atof(value);  found = true; }
+    FOR_ALL_SYNTHETIC_HEAP_PARAMETERS_DO(PARSE_PARAMETER)
+# undef PARSE_PARAMETER
+    if (!found)
+      usage();
+  }
+  free(s);
+  if (objects < 1  ||  fanout < 0  ||  max_slots < fanout  ||  gcs < 0)
+    usage();
+}
+
+
+// Some weak class without fixed fields, WeakArray in a Squeak image or in the minimal one, or nil.
+static Oop find_weak_array_class() {
+  Memory_System* const ms = The_Memory_System();
+  FOR_ALL_RANKS(r)
+    for (int m = 0;  m < Memory_System::max_num_mutabilities;  ++m)
+      FOR_EACH_OBJECT_IN_HEAP(ms->heaps[r][m], obj)
+        if (!obj->isFreeObject()  &&  obj->isWeak()  &&  obj->nonWeakFieldsOf() == 0)
+          return obj->fetchClass();
+  return The_Squeak_Interpreter()->roots.nilObj;
+}
+
+
+void Synthetic_Heap::build_collect_and_exit() {
+  parse_spec();
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  Memory_System* const ms = The_Memory_System();
+  Safepoint_Ability sa(true);
+  random_state = seed == 0  ?  1  :  seed;
+
+  Oop array_class = interp->splObj(Special_Indices::ClassArray);
+  Oop weak_class = find_weak_array_class();
+  if (weak > 0  &&  weak_class == interp->roots.nilObj) {
+    lprintf("synthetic heap: no weak array class in the image, so no weak objects\n");
+    weak = 0;
+  }
+
+  const int cores = Logical_Core::group_size;
+  std::vector<Oop> live[Max_Number_Of_Cores], unreferenced[Max_Number_Of_Cores], weakly_unreferenced[Max_Number_Of_Cores];
+  int built = 0, garbage_built = 0, weak_built = 0, weakly_held_built = 0, roots = 0;
+  u_int64 slots = 0, references = 0, cross_core_references = 0;
+  u_int64 start_usecs = GC_Log::now_usecs();
+  {
+    Safepoint_for_moving_objects sf("synthetic heap");
+    Safepoint_Ability sa(false); // no GC till every live object is rooted
+
+    for (int i = 0;  i < objects;  ++i) {
+      const int r = i % cores;
+      const bool is_live = random_fraction() >= garbage;
+      const bool is_weak = random_fraction() < weak;
+      const bool is_weakly_held = is_live  &&  !is_weak  &&  random_fraction() < weakly_held;
+      const int n = log_uniform(fanout, max_slots);
+      Multicore_Object_Heap* h = ms->heaps[r][Memory_System::read_write];
+      if (h->bytesLeft()  <  u_int32((n + 8) * bytesPerWord  +  h->get_lowSpaceThreshold()  +  4096)) {
+        lprintf("synthetic heap: core %d is full after %d objects; try a bigger -min_heap_MB\n", r, i);
+        break;
+      }
+      Object_p xo = (is_weak ? weak_class : array_class).as_object()->instantiateClass(n, &logical_cores[r]);
+      Oop x = xo->as_oop();
+
+      // Live strong objects refer to those no other object does yet, so all the live ones end up reachable;
+      // live weak objects refer to weakly held ones first, so those are reachable only weakly.
+      for (int k = 0;  k < fanout;  ++k) {
+        int t = r;
+        if (cores > 1  &&  random_fraction() < cross_core)
+          t = (r + 1 + random_below(cores - 1)) % cores;
+        Oop child;
+        if (is_live  &&  !is_weak  &&  !is_weakly_held  &&  !unreferenced[t].empty()) {
+          child = unreferenced[t].back();
+          unreferenced[t].pop_back();
+        }
+        else if (is_live  &&  is_weak  &&  !weakly_unreferenced[t].empty()) {
+          child = weakly_unreferenced[t].back();
+          weakly_unreferenced[t].pop_back();
+        }
+        else if (!live[t].empty())
+          child = live[t][random_below(live[t].size())];
+        else
+          continue;
+        xo->storePointer(k, child);
+        ++references;
+        if (t != r)  ++cross_core_references;
+      }
+      if (is_weakly_held)
+        weakly_unreferenced[r].push_back(x);
+      else if (is_live) {
+        live[r].push_back(x);
+        unreferenced[r].push_back(x);
+      }
+      ++built;
+      slots += n;
+      if (!is_live)        ++garbage_built;
+      if (is_weak)         ++weak_built;
+      if (is_weakly_held)  ++weakly_held_built;
+    }
+
+    FOR_ALL_RANKS(r)
+      roots += unreferenced[r].size();
+    Multicore_Object_Heap* h = ms->heaps[Logical_Core::my_rank()][Memory_System::read_write];
+    if (h->bytesLeft()  <  u_int32((roots + 8) * bytesPerWord  +  h->get_lowSpaceThreshold()))
+      fatal("synthetic heap: no room for the roots; try a bigger -min_heap_MB or fanout");
+    Object_p ro = array_class.as_object()->instantiateClass(roots);
+    int j = 0;
+    FOR_ALL_RANKS(r)
+      for (size_t k = 0;  k < unreferenced[r].size();  ++k)
+        ro->storePointer(j++, unreferenced[r][k]);
+    interp->pushRemappableOop(ro->as_oop()); // a root till we quit
+  }
+
+  u_int64 build_usecs = GC_Log::now_usecs() - start_usecs;
+
+  fprintf(stdout, "synthetic heap on %d cores: %d objects, %d garbage, %d weak, %d weakly held, %llu slots, %llu references, "
+                  "%.1f%% across cores, %d roots, built in %.1f ms\n",
+          cores, built, garbage_built, weak_built, weakly_held_built, slots, references,
+          references == 0  ?  0.0  :  100.0 * cross_core_references / references,
+          roots, build_usecs / 1000.0);
+
+  // the Oops of garbage objects go bad with the first GC
+  FOR_ALL_RANKS(r) {
+    std::vector<Oop>().swap(live[r]);
+    std::vector<Oop>().swap(unreferenced[r]);
+    std::vector<Oop>().swap(weakly_unreferenced[r]);
+  }
+
+  u_int64 total_usecs = 0, min_usecs = ~0ULL, max_usecs = 0;
+  for (int g = 0;  g < gcs;  ++g) {
+    u_int64 start = GC_Log::now_usecs();
+    ms->fullGC("synthetic heap");
+    u_int64 usecs = GC_Log::now_usecs() - start;
+    total_usecs += usecs;
+    min_usecs = min(min_usecs, usecs);
+    max_usecs = max(max_usecs, usecs);
+    fprintf(stdout, "%s\n", ms->gc_log()->get_last_record());
+  }
+  if (gcs > 0)
+    fprintf(stdout, "synthetic heap: %d full GCs, min %.3f ms, mean %.3f ms, max %.3f ms\n",
+            gcs, min_usecs / 1000.0, total_usecs / 1000.0 / gcs, max_usecs / 1000.0);
+  fflush(stdout);
+  ioExit();
+}
+
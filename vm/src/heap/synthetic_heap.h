@@ -0,0 +1,57 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// Builds a synthetic object graph over the per-core heaps and times full GCs of it,
+// to try collector changes on heaps of any size and shape, the same way every time.
+// -synthetic_heap "objects=1000000,fanout=4,cross_core=0.2,gcs=10" (see FOR_ALL_SYNTHETIC_HEAP_PARAMETERS_DO)
+// The collector needs the interpreter, the object table and the other cores answering messages,
+// and the objects need classes, so this runs in place of the image, like -microbench,
+// on the image given, which it reads only for Array and a weak class, or if none is given,
+// on a minimal image that the VM writes and boots from (see image_readers/minimal_image.h).
+// Objects are Arrays, or weak arrays, of log-uniformly distributed size, built round robin
+// over the cores, each pointing at fanout earlier objects. Live objects are all reachable, from
+// later live objects or from a root Array in the interpreter's remap buffer; garbage objects
+// point at live ones but nothing points at them. Weakly held objects are only pointed at by weak
+// objects, so every GC has weak slots to clear. Everything is built in the read-write heaps:
+// main says moving to the read-mostly heaps in bulk does not work yet, so this does not try.
+// Prints each GC's GC_Log record, then quits. make gc-bench runs it at each of BENCH_CORES cores.
+
+class Synthetic_Heap {
+public:
+  static char* spec; // -synthetic_heap
+
+# define FOR_ALL_SYNTHETIC_HEAP_PARAMETERS_DO(template) \
+  template(objects,     int,    100000, "objects to build, round robin over the cores") \
+  template(fanout,      int,    2,      "references from each object to earlier ones") \
+  template(max_slots,   int,    16,     "pointer slots per object, log-uniform from fanout up to this") \
+  template(cross_core,  double, 0.1,    "share of references to objects on other cores") \
+  template(weak,        double, 0.05,   "share of objects that are weak") \
+  template(weakly_held, double, 0.02,   "share of objects only weak objects point at") \
+  template(garbage,     double, 0.3,    "share of objects left unreachable") \
+  template(gcs,         int,    5,      "full GCs to time") \
+  template(seed,        int,    1,      "for the random choices")
+
+private:
+# define DECLARE_PARAMETER(name, type, default_value, explanation) static type name;
+  FOR_ALL_SYNTHETIC_HEAP_PARAMETERS_DO(DECLARE_PARAMETER)
+# undef DECLARE_PARAMETER
+
+  static void parse_spec();
+  static void usage();
+
+public:
+  static bool is_requested() { return spec != NULL; }
+  static void build_collect_and_exit();
+};
+
@@ -0,0 +1,251 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+
+
+#include "headers.h"
+
+
+Minimal_Image::Minimal_Image() {
+  word_count = 0;
+  word_capacity = 1024;
+  words = (int32*)malloc(word_capacity * sizeof(int32));
+  if (words == NULL)
+    fatal("minimal image");
+  last_hash = 0;
+  nil = class_class = byte_string_class = array_class = 0;
+}
+
+
+void Minimal_Image::add_word(int32 w) {
+  if (word_count == word_capacity) {
+    word_capacity *= 2;
+    words = (int32*)realloc(words, word_capacity * sizeof(int32));
+    if (words == NULL)
+      fatal("minimal image");
+  }
+  words[word_count++] = w;
+}
+
+
+// Lays out the header words the way an image saves them, without preheaders, and answers the Oop.
+// Pointer fields start out nil; a nil klass gets set later.
+int32 Minimal_Image::instantiate(int32 klass, int format, int slots, int compact_class_index, int unused_bytes) {
+  const int32 byte_size = (slots + 1) * sizeof(int32);
+  int32 header = ((++last_hash << Object::HashShift) & Object::HashMask)
+              |  (compact_class_index << Object::CompactClassShift)
+              |  ((format | unused_bytes) << Object::FormatShift);
+  if (byte_size > 255) {
+    add_word(byte_size | Header_Type::SizeAndClass);
+    add_word(klass     | Header_Type::SizeAndClass);
+    header |= Header_Type::SizeAndClass;
+  }
+  else if (compact_class_index != 0)
+    header |= byte_size | Header_Type::Short;
+  else {
+    add_word(klass | Header_Type::Class);
+    header |= byte_size | Header_Type::Class;
+  }
+  const int32 oop = base + word_count * sizeof(int32);
+  add_word(header);
+  const int32 fill = Object::Format::has_only_oops(format)  ?  nil  :  0;
+  for (int i = 0;  i < slots;  ++i)
+    add_word(fill);
+  return oop;
+}
+
+
+void Minimal_Image::set_class(int32 oop, int32 klass) {
+  int32& class_word = words[(oop - base) / sizeof(int32)  -  1];
+  class_word = klass | Header_Type::extract_from(class_word);
+}
+
+
+int32 Minimal_Image::string(const char* s) {
+  const int n = strlen(s);
+  const int slots = divide_and_round_up(n, sizeof(int32));
+  int32 oop = instantiate(byte_string_class, Object::Format::indexable_byte_fields_only_0, slots, 0, slots * sizeof(int32) - n);
+  memcpy(fields_of(oop), s, n);
+  return oop;
+}
+
+
+int32 Minimal_Image::array(int n) {
+  return instantiate(array_class, Object::Format::indexable_fields_only, n);
+}
+
+
+// Classes are superclass, methodDict, format, instanceVariables, organization, subclasses, name,
+// with the instance variable names, if any, separated by spaces.
+int32 Minimal_Image::new_class(const char* name, int32 superclass, int format, int fixed_fields,
+                               const char* instance_variable_names, int compact_class_index) {
+  const int32 instance_bytes = (fixed_fields + 1) * sizeof(int32);
+  assert_always(instance_bytes <= Object::SizeMask);
+  int32 klass = instantiate(class_class, Object::Format::fixed_fields_only, 7);
+  fields_of(klass)[Object_Indices::SuperclassIndex] = superclass;
+  fields_of(klass)[Object_Indices::InstanceSpecificationIndex] =
+    (format << Object::FormatShift)  |  instance_bytes  |  (compact_class_index << Object::CompactClassShift)  |  Int_Tag;
+
+  if (instance_variable_names != NULL) {
+    char* s = strdup(instance_variable_names);
+    int n = 0;
+    int32 names[16];
+    char* rest = NULL;
+    for (char* ivar = strtok_r(s, " ", &rest);  ivar != NULL;  ivar = strtok_r(NULL, " ", &rest)) {
+      assert_always(n < int(sizeof(names) / sizeof(names[0])));
+      names[n++] = string(ivar);
+    }
+    free(s);
+    int32 a = array(n);
+    for (int i = 0;  i < n;  ++i)
+      fields_of(a)[i] = names[i];
+    fields_of(klass)[3] = a;
+  }
+  if (name != NULL)
+    name_class(klass, name);
+  return klass;
+}
+
+
+void Minimal_Image::name_class(int32 klass, const char* name) {
+  int32 s = string(name);
+  fields_of(klass)[Object_Indices::Class_Name_Index] = s;
+}
+
+
+int32 Minimal_Image::build() {
+  // nil and the class of all classes come first, since everything else refers to them
+  nil = instantiate(0, Object::Format::no_fields, 0);
+  class_class = instantiate(0, Object::Format::fixed_fields_only, 7);
+  set_class(class_class, class_class);
+  fields_of(class_class)[Object_Indices::InstanceSpecificationIndex] =
+    (Object::Format::fixed_fields_only << Object::FormatShift)  |  (8 * sizeof(int32))  |  Int_Tag;
+
+  int32 object_class      = new_class(NULL, nil, Object::Format::no_fields, 0);
+  byte_string_class       = new_class(NULL, object_class, Object::Format::indexable_byte_fields_only_0, 0);
+  array_class             = new_class(NULL, object_class, Object::Format::indexable_fields_only, 0);
+  name_class(class_class,       "Class");
+  name_class(object_class,      "Object");
+  name_class(byte_string_class, "ByteString");
+  name_class(array_class,       "Array");
+
+  int32 undefined_object_class = new_class("UndefinedObject", object_class, Object::Format::no_fields, 0);
+  int32 false_class            = new_class("False",           object_class, Object::Format::no_fields, 0);
+  int32 true_class             = new_class("True",            object_class, Object::Format::no_fields, 0);
+  int32 small_integer_class    = new_class("SmallInteger",    object_class, Object::Format::no_fields, 0);
+  int32 weak_array_class       = new_class("WeakArray",       object_class, Object::Format::both_fixed_and_indexable_weak_fields, 0);
+  int32 association_class      = new_class("Association",     object_class, Object::Format::fixed_fields_only, 2);
+  int32 scheduler_class        = new_class("ProcessorScheduler", object_class, Object::Format::fixed_fields_only, 2);
+  int32 linked_list_class      = new_class("LinkedList",      object_class, Object::Format::fixed_fields_only, 2);
+  int32 compiled_method_class  = new_class("CompiledMethod",  object_class, Object::Format::compiled_method_0, 0);
+  int32 method_context_class   = new_class("MethodContext",   object_class, Object::Format::both_fixed_and_indexable_fields,
+                                           Object_Indices::CtextTempFrameStart, NULL, Object::CompactClass::MethodContext);
+  // The_Process_Field_Locator and The_OstDomain find fields by name, and Process_Field_Locator insists on suspendedContext
+  int32 link_class             = new_class("Link",            object_class, Object::Format::fixed_fields_only, 1, "nextLink");
+  int32 process_class          = new_class("Process",         link_class,   Object::Format::fixed_fields_only, 6,
+                                           "suspendedContext priority myList errorHandler name");
+  int32 ost_domain_class       = new_class("OstDomain",       object_class, Object::Format::fixed_fields_only, 2,
+                                           "domainForNewObjects domainCustomizations");
+  set_class(nil, undefined_object_class);
+  int32 false_object = instantiate(false_class, Object::Format::no_fields, 0);
+  int32 true_object  = instantiate(true_class,  Object::Format::no_fields, 0);
+
+  // an empty method that would just return self
+  int32 method = instantiate(compiled_method_class, Object::Format::compiled_method_0, 2, 0, 3);
+  fields_of(method)[Object_Indices::HeaderIndex] = Oop::from_int(0).bits(); // no literals, temporaries or arguments
+  ((u_char*)&fields_of(method)[Object_Indices::LiteralStart])[0] = 0x78; // returnReceiver
+
+  const int context_slots = Object_Indices::SmallContextSize / bytesPerWord  -  1;
+  int32 context = instantiate(0, Object::Format::both_fixed_and_indexable_fields, context_slots, Object::CompactClass::MethodContext);
+  fields_of(context)[Object_Indices::InstructionPointerIndex] = Oop::from_int(Object_Indices::LiteralStart * bytesPerWord + 1).bits();
+  fields_of(context)[Object_Indices::StackPointerIndex] = Oop::from_int(0).bits();
+  fields_of(context)[Object_Indices::MethodIndex] = method;
+
+  int32 process = instantiate(process_class, Object::Format::fixed_fields_only, 6);
+  fields_of(process)[Object_Indices::SuspendedContextIndex] = context;
+  fields_of(process)[Object_Indices::PriorityIndex] = Oop::from_int(process_priority).bits();
+
+  int32 process_lists = array(priorities);
+  for (int i = 0;  i < priorities;  ++i) {
+    int32 list = instantiate(linked_list_class, Object::Format::fixed_fields_only, 2);
+    fields_of(process_lists)[i] = list;
+  }
+  int32 scheduler = instantiate(scheduler_class, Object::Format::fixed_fields_only, 2);
+  fields_of(scheduler)[Object_Indices::ProcessListsIndex] = process_lists;
+  fields_of(scheduler)[Object_Indices::ActiveProcessIndex] = process;
+  int32 scheduler_association = instantiate(association_class, Object::Format::fixed_fields_only, 2);
+  fields_of(scheduler_association)[Object_Indices::ValueIndex] = scheduler;
+
+  int32 compact_classes = array(31);
+  fields_of(compact_classes)[Object::CompactClass::MethodContext - 1] = method_context_class;
+
+  // referred to by nothing, only so that -synthetic_heap finds a weak class, as it would in a real image
+  instantiate(weak_array_class, Object::Format::both_fixed_and_indexable_weak_fields, 0);
+
+  int32 special_objects = array(Special_Indices::ArrayOstDomainSelectors + 1);
+  int32* s = fields_of(special_objects);
+  s[Special_Indices::NilObject]            = nil;
+  s[Special_Indices::FalseObject]          = false_object;
+  s[Special_Indices::TrueObject]           = true_object;
+  s[Special_Indices::SchedulerAssociation] = scheduler_association;
+  s[Special_Indices::ClassInteger]         = small_integer_class;
+  s[Special_Indices::ClassString]          = byte_string_class;
+  s[Special_Indices::ClassArray]           = array_class;
+  s[Special_Indices::ClassMethodContext]   = method_context_class;
+  s[Special_Indices::ClassCompiledMethod]  = compiled_method_class;
+  s[Special_Indices::ClassProcess]         = process_class;
+  s[Special_Indices::CompactClasses]       = compact_classes;
+  s[Special_Indices::ClassOstDomain]       = ost_domain_class;
+  return special_objects;
+}
+
+
+// The header Squeak_Image_Reader::read_header expects, padded to 64 bytes, then the objects.
+bool Minimal_Image::write_to(FILE* f, int32 special_objects) {
+  const int32 header_size = 64;
+  int32 header[header_size / sizeof(int32)];
+  bzero(header, sizeof(header));
+  header[0] = Squeak_Image_Reader::Post_Closure_32_Bit_Image_Version;
+  header[1] = header_size;
+  header[2] = word_count * sizeof(int32);
+  header[3] = base;
+  header[4] = special_objects;
+  header[5] = last_hash;
+  header[6] = (640 << 16) | 480; // savedWindowSize
+  header[7] = 0; // fullScreenFlag
+  header[8] = 0; // extraVMMemory
+  return fwrite(header, sizeof(header), 1, f) == 1
+     &&  fwrite(words, sizeof(int32), word_count, f) == word_count;
+}
+
+
+void Minimal_Image::write(char* file_name) {
+  strcpy(file_name, "/tmp/omnivm-minimal-XXXXXX.image");
+  int fd = mkstemps(file_name, 6);
+  if (fd < 0) {
+    perror("minimal image");
+    fatal("could not make a file for the minimal image");
+  }
+  FILE* f = fdopen(fd, "w");
+  Minimal_Image mi;
+  int32 special_objects = mi.build();
+  bool ok = mi.write_to(f, special_objects);
+  if (fclose(f) != 0)  ok = false;
+  if (!ok) {
+    perror("minimal image");
+    unlink(file_name);
+    fatal("could not write the minimal image");
+  }
+  fprintf(stdout, "wrote a minimal image of %lu bytes to %s\n", mi.word_count * sizeof(int32), file_name);
+}
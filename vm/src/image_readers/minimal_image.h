@@ -0,0 +1,52 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+
+
+// Writes a tiny 32-bit Squeak image, made up on the spot: nil, false, true, the special objects array,
+// a scheduler whose active process sits in a method context of an empty method, and the classes of these,
+// along with Array, WeakArray and ByteString. There is nothing in it to run, so it only suits VM modes
+// that quit before interpreting: -synthetic_heap boots from it when given no image,
+// so that the collector can be timed, by make gc-bench for one, without any real image at hand.
+
+class Minimal_Image {
+  static const int32 base = 0x10000; // where the objects pretend to have been saved
+  static const int priorities = 80;
+  static const int process_priority = 40; // userSchedulingPriority
+
+  int32* words; // the objects, as they go into the file
+  u_int32 word_count, word_capacity;
+  int32 last_hash;
+
+  int32 nil, class_class, byte_string_class, array_class;
+
+  Minimal_Image();
+  ~Minimal_Image() { free(words); }
+
+  void    add_word(int32);
+  int32   instantiate(int32 klass, int format, int slots, int compact_class_index = 0, int unused_bytes = 0);
+  int32*  fields_of(int32 oop) { return &words[(oop - base) / sizeof(int32)  +  1]; }
+  void    set_class(int32 oop, int32 klass);
+  int32   string(const char*);
+  int32   array(int n);
+  int32   new_class(const char* name, int32 superclass, int format, int fixed_fields,
+                    const char* instance_variable_names = NULL, int compact_class_index = 0);
+  void    name_class(int32 klass, const char* name);
+  int32   build(); // answers the special objects array
+  bool    write_to(FILE*, int32 special_objects);
+
+public:
+  static void write(char* file_name); // into a new temporary file, whose name it puts in file_name
+};
+
@@ -16,6 +16,11 @@
 
 # include <fcntl.h>
 # include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+
+
+bool Squeak_Image_Reader::load_in_parallel = true;
 
 
 void Squeak_Image_Reader::read(char* fileName, Memory_System* ms, Squeak_Interpreter* i) {
@@ -44,6 +49,9 @@ Squeak_Image_Reader::Squeak_Image_Reader(char* fn, Memory_System* ms, Squeak_Int
   file_name = fn;
   image_file = fopen(file_name, "r");
   swap_bytes = false;
+  mapped_image = NULL;
+  mapped_image_size = 0;
+  distributing_in_parallel = false;
   if (image_file == NULL) {
     char buf[BUFSIZ];
     snprintf(buf, sizeof(buf), "Could not open image file %s", file_name);
@@ -77,27 +85,34 @@ readImageFromFile: f HeapSize: desiredHeapSize StartingAt: imageOffset
 
   read_header();
 
-  if (Verbose_Debug_Prints) fprintf(stdout, "allocating memory for snapshot\n");
+  distributing_in_parallel = can_distribute_in_parallel();
+
+  if (distributing_in_parallel  &&  map_image()) {
+    if (Verbose_Debug_Prints) fprintf(stdout, "mapped snapshot\n");
+  }
+  else {
+    if (Verbose_Debug_Prints) fprintf(stdout, "allocating memory for snapshot\n");
 
-  // "allocate a contiguous block of memory for the Squeak heap"
-  memory = (char*)Memory_Semantics::shared_malloc(dataSize);
-  assert_always(memory != NULL);
+    // "allocate a contiguous block of memory for the Squeak heap"
+    memory = (char*)Memory_Semantics::shared_malloc(dataSize);
+    assert_always(memory != NULL);
 
-  /*
+    /*
 	memStart := self startOfMemory.
 	memoryLimit := (memStart + heapSize) - 24.  "decrease memoryLimit a tad for safety"
 	endOfMemory := memStart + dataSize.
-  */
+    */
 
-  // "position file after the header"
-  if (Verbose_Debug_Prints) fprintf(stdout, "reading objects in snapshot\n");
-  if (fseek(image_file, headerStart + headerSize, SEEK_SET)) {
-    perror("seek");
-    fatal();
-  }
+    // "position file after the header"
+    if (Verbose_Debug_Prints) fprintf(stdout, "reading objects in snapshot\n");
+    if (fseek(image_file, headerStart + headerSize, SEEK_SET)) {
+      perror("seek");
+      fatal();
+    }
 
-  // "read in the image in bulk, then swap the bytes if necessary"
-  xfread(memory, 1, dataSize, image_file);
+    // "read in the image in bulk, then swap the bytes if necessary"
+    xfread(memory, 1, dataSize, image_file);
+  }
 
   // "First, byte-swap every word in the image. This fixes objects headers."
   if (swap_bytes) reverseBytes((int32*)&memory[0], (int32*)&memory[dataSize]);
@@ -288,6 +303,11 @@ void Squeak_Image_Reader::distribute_objects() {
 
   memory_system->initialize_from_snapshot(dataSize, savedWindowSize, fullScreenFlag, lastHash);
   
+  if (distributing_in_parallel)
+    partition_image();
+  
+  // When distributing in parallel, this pass only assigns OTEs and relocates pointers;
+  // the cores copy the objects afterwards.
   for (Chunk *c = (Chunk*)base, *nextChunk = NULL;
        (char*)c <  &base[total_bytes];
        c = nextChunk) {
@@ -300,9 +320,14 @@ void Squeak_Image_Reader::distribute_objects() {
     nextChunk = obj->nextChunk();
     if (!obj->isFreeObject()) {
       obj->do_all_oops_of_object_for_reading_snapshot(this);
-      memory_system->ask_cpu_core_to_add_object_from_snapshot_allocating_chunk(oop_for_addr(obj), obj);
+      Oop dst_oop = oop_for_addr(obj);
+      if (!distributing_in_parallel)
+        memory_system->ask_cpu_core_to_add_object_from_snapshot_allocating_chunk(dst_oop, obj);
     }
   }
+  if (distributing_in_parallel)
+    add_objects_on_all_cores();
+  
   // Remap specialObjectsOop
   specialObjectsOop = oop_for_oop(specialObjectsOop);
 
@@ -310,6 +335,7 @@ void Squeak_Image_Reader::distribute_objects() {
   
   memory_system->finished_adding_objects_from_snapshot();
   free(object_oops);
+  unmap_image();
   fprintf(stdout, "done distributing objects, %lld cycles\n",
     OS_Interface::get_cycle_count() - start);
 
@@ -333,8 +359,113 @@ Oop Squeak_Image_Reader::oop_for_relative_addr(int relative_addr) {
   Object* obj = (Object*) &memory[relative_addr];
   if (addr_in_table->bits() == 0) {
     Object_Table* const ot = memory_system->object_table;
-    *addr_in_table = ot->allocate_OTE_for_object_in_snapshot(obj);
+    int rank = distributing_in_parallel  ?  rank_for_relative_addr(relative_addr)
+                                         :  memory_system->assign_rank_for_snapshot_object();
+    *addr_in_table = ot->allocate_OTE_for_object_in_snapshot(obj, rank);
   }
   return *addr_in_table;
 }
 
+
+// Parallel loading needs every core to see the reader's memory and to set OTEs directly.
+bool Squeak_Image_Reader::can_distribute_in_parallel() {
+  return load_in_parallel  &&  Using_Threads  &&  Use_Object_Table  &&  Logical_Core::group_size > 1;
+}
+
+
+// Map the file copy-on-write, since pointers get relocated (and maybe bytes swapped) in place.
+// Returns false if mapping is not possible; the caller then reads the image as before.
+bool Squeak_Image_Reader::map_image() {
+  struct stat st;
+  if (fstat(fileno(image_file), &st) != 0) {
+    perror("fstat of image file");
+    return false;
+  }
+  const size_t data_offset = headerStart + headerSize;
+  if (size_t(st.st_size) < data_offset + dataSize  ||  data_offset % sizeof(Oop) != 0)
+    return false;
+  
+  void* p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(image_file), 0);
+  if (p == MAP_FAILED) {
+    perror("mmap of image file failed, reading it instead");
+    return false;
+  }
+  madvise(p, st.st_size, MADV_WILLNEED);
+  
+  mapped_image = (char*)p;
+  mapped_image_size = st.st_size;
+  memory = mapped_image + data_offset;
+  return true;
+}
+
+
+void Squeak_Image_Reader::unmap_image() {
+  if (mapped_image == NULL)
+    return;
+  munmap(mapped_image, mapped_image_size);
+  mapped_image = memory = NULL;
+  mapped_image_size = 0;
+}
+
+
+// Cut the image at chunk boundaries into one range of about equal size per core.
+// Everything goes into read-write heaps at this point (see mutability_for_snapshot_object),
+// so equal byte counts mean equally full heaps, as with round-robin assignment.
+void Squeak_Image_Reader::partition_image() {
+  const int n = Logical_Core::group_size;
+  const u_int32 share = divide_and_round_up(dataSize, n);
+  int r = 0;
+  for (Chunk* c = (Chunk*)memory;  (char*)c < &memory[dataSize];  ) {
+    u_int32 offset = (char*)c - memory;
+    while (r < n - 1  &&  offset >= share * (r + 1))
+      partition_ends[r++] = offset;
+    c = c->object_from_chunk_without_preheader()->nextChunk();
+  }
+  while (r < n)
+    partition_ends[r++] = dataSize;
+}
+
+
+int Squeak_Image_Reader::rank_for_relative_addr(u_int32 relative_addr) {
+  int lo = 0,  hi = Logical_Core::group_size - 1;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (relative_addr < partition_ends[mid])  hi = mid;
+    else                                      lo = mid + 1;
+  }
+  return lo;
+}
+
+
+// No per-object messages: each core gets one message and copies its whole range.
+void Squeak_Image_Reader::add_objects_on_all_cores() {
+  FOR_ALL_OTHER_RANKS(r)
+    loadSnapshotPartitionMessage_class(this).send_to(r);
+  
+  add_objects_in_my_partition();
+  
+  FOR_ALL_OTHER_RANKS(r)
+    WAIT_FOR_MESSAGE(loadSnapshotPartitionResponse, r);
+}
+
+
+void Squeak_Image_Reader::add_objects_in_my_partition() {
+  const int r = Logical_Core::my_rank();
+  char* start = &memory[r == 0  ?  0  :  partition_ends[r - 1]];
+  char* end   = &memory[partition_ends[r]];
+  Object_Table* const ot = memory_system->object_table;
+  
+  for (Chunk *c = (Chunk*)start, *nextChunk = NULL;
+       (char*)c < end;
+       c = nextChunk) {
+    Object* obj = c->object_from_chunk_without_preheader();
+    nextChunk = obj->nextChunk();
+    if (obj->isFreeObject())
+      continue;
+    
+    Oop dst_oop = object_oops[((char*)obj - memory) / sizeof(Oop)];
+    Object_p dst_obj = (Object_p)memory_system->add_object_from_snapshot_to_a_local_heap_allocating_chunk(dst_oop, obj);
+    ot->set_object_for(dst_oop, dst_obj  COMMA_FALSE_OR_NOTHING);
+  }
+}
+
@@ -25,6 +25,13 @@ class Squeak_Image_Reader {
   char *oldBaseAddr, *memory;
   Oop* object_oops;
 
+  // When loading in parallel, the image is mmapped rather than read, and
+  // rank r adds the objects in [partition_ends[r-1], partition_ends[r]) (relative to memory).
+  char* mapped_image;
+  size_t mapped_image_size;
+  bool distributing_in_parallel;
+  u_int32 partition_ends[Max_Number_Of_Cores];
+
 
   // need to be passed on
   Oop specialObjectsOop; // -> The_Squeak_Interpreter()->roots.specialObjectsOop
@@ -44,10 +51,18 @@ class Squeak_Image_Reader {
   void byteSwapByteObjects();
   void normalize_float_ordering_in_image();
   void distribute_objects();
+  bool can_distribute_in_parallel();
+  bool map_image();
+  void unmap_image();
+  void partition_image();
+  int  rank_for_relative_addr(u_int32);
+  void add_objects_on_all_cores();
   
   void complete_remapping_of_pointers();
 
 public:
+  static bool load_in_parallel; // threadsafe readonly config value
+  void add_objects_in_my_partition();
   static void imageNamePut_on_all_cores(char*  b, unsigned int n);
   Oop oop_for_oop(Oop);
 private:
@@ -534,7 +534,7 @@ void Squeak_Interpreter::primitiveDoNamedPrimitiveWithArgs() {
   // run the prim
   pushRemappableOop(argumentArray); // might alloc
   roots.lkupClass = roots.nilObj;
-  dispatchFunctionPointer(addr, true);
+  dispatchFunctionPointer(addr, true, false); // must repair the stack below
   argumentArray = popRemappableOop();
   argumentArray_obj = argumentArray.as_object();
   
@@ -921,14 +921,25 @@ void Squeak_Interpreter::primitiveFloatNotEqual() {
   if (successFlag) { pop(2); pushBool(!b); }
 }
 void Squeak_Interpreter::primitiveFlushCache() {
-  flushMethodCacheMessage_class().send_to_all_cores();
+  if (coalesced_broadcasts != NULL)
+    coalesced_broadcasts->flush_method_cache_everywhere();
+  else
+    flushMethodCacheMessage_class().send_to_all_cores();
 }
 void Squeak_Interpreter::primitiveFlushCacheByMethod() {
+  if (coalesced_broadcasts != NULL) {
+    coalesced_broadcasts->flush_by_method_everywhere(stackTop());
+    return;
+  }
   pushRemappableOop(stackTop()); // in case of gc while message in transit
   flushByMethodMessage_class(stackTop()).send_to_all_cores();
   popRemappableOop();
 }
 void Squeak_Interpreter::primitiveFlushCacheSelective() {
+  if (coalesced_broadcasts != NULL) {
+    coalesced_broadcasts->flush_selective_everywhere(stackTop());
+    return;
+  }
   pushRemappableOop(stackTop()); // in case of gc while message in transit
   flushSelectiveMessage_class(stackTop()).send_to_all_cores();
   popRemappableOop();
@@ -1856,6 +1867,12 @@ void Squeak_Interpreter::primitiveQuit() {
   OS_Interface::sim_end_tracing();
   OS_Interface::profiler_disable();
   The_Measurements.print();
+  if (Safepoint_Stats::print_at_exit  &&  safepoint_stats != NULL)
+    safepoint_stats->print();
+  Sampling_Profiler::write_file_if_requested();
+  Allocation_Profiler::write_file_if_requested();
+  if (timeline != NULL)
+    timeline->write(Timeline::file_name);
   ioExit();
  }
 
@@ -2359,6 +2376,8 @@ void Squeak_Interpreter::primitiveVMParameter() {
   if (get_argumentCount() == 0) {
     Object_p ro = splObj_obj(Special_Indices::ClassArray)->instantiateClass(paramsArraySize);
     for (int i = 0;  i < paramsArraySize;  ++i)  ro->storePointer(i, Oop::from_int(0));
+    ro->storePointer( 6, Oop::from_int(The_Memory_System()->get_gcCount()));
+    ro->storePointer( 7, Oop::from_int(The_Memory_System()->get_gcMilliseconds()));
     ro->storePointer(23, Oop::from_int(The_Memory_System()->get_shrinkThreshold()));
     ro->storePointer(24, Oop::from_int(The_Memory_System()->get_growHeadroom()   ));
 
@@ -2369,6 +2388,13 @@ void Squeak_Interpreter::primitiveVMParameter() {
     if (!arg.is_int()) { primitiveFail(); return; }
     oop_int_t argi = arg.integerValue();
     oop_int_t result;
+    // beyond the Squeak ones: the last full GC as a line of JSON, and the pause histogram, see GC_Log
+    if (argi == 101  ||  argi == 102) {
+      GC_Log* log = The_Memory_System()->gc_log();
+      Oop r = argi == 101  ?  Object::makeString(log->get_last_record())->as_oop()  :  log->get_pause_histogram();
+      popThenPush(2, r);
+      return;
+    }
     switch (argi) {
         default:
           lprintf("primitiveVMParameter: attempt to get %d\n", argi);
@@ -2377,6 +2403,8 @@ void Squeak_Interpreter::primitiveVMParameter() {
         // case 0:  result = 0x828677; break; // ASCII value of RVM (RoarVM is to long to fit into SmallInt)
         case 0:  result = 0x798677; break; // ASCII value of OVM (OmniVM is to long to fit into SmallInt)
         
+        case  7: result = The_Memory_System()->get_gcCount(); break;
+        case  8: result = The_Memory_System()->get_gcMilliseconds(); break;
         case 24: result = The_Memory_System()->get_shrinkThreshold(); break;
         case 25: result = The_Memory_System()->get_growHeadroom(); break;
     }
@@ -50,8 +50,19 @@ Squeak_Interpreter::Squeak_Interpreter()
 
   safepoint_tracker = NULL;
   safepoint_master_control = NULL;
+  safepoint_epochs = NULL;
+  safepoint_stats = NULL;
   safepoint_ability = NULL;
 
+  run_queues = NULL;
+  coalesced_broadcasts = NULL;
+  timeline = NULL;
+  running_primitive_index = 0;
+  nonempty_ready_lists = NULL;
+  last_dropped_hints_epoch = -1; // walk the lists the first time, they came with the image
+  wakeups_since_walking_process_lists = 0;
+  searches_since_resync = 0;
+
 
   registers_stored();
   uninternalized(); unexternalized();
@@ -97,9 +108,21 @@ void Squeak_Interpreter::initialize(Oop soo, bool from_checkpoint) {
     scheduler_mutex.initialize_globals();
     semaphore_mutex.initialize_globals();
 
-    safepoint_tracker = new Safepoint_Tracker();
+    if (Safepoint_Tracker::use_shared_memory  &&  Using_Threads)
+      safepoint_epochs = Safepoint_Epochs::create();
+    safepoint_stats = Safepoint_Stats::create();
+    safepoint_tracker = new Safepoint_Tracker(safepoint_epochs);
     safepoint_master_control = new Safepoint_Master_Control();
 
+    if (Run_Queues::use_run_queues)
+      run_queues = Run_Queues::create();
+    if (Timeline::file_name != NULL)
+      timeline = Timeline::create();
+    if (Allocation_Profiler::file_name != NULL)
+      Allocation_Profiler::start(Allocation_Profiler::default_sample_bytes, true);
+    // all clear: the first search will resync it with the lists in the image
+    nonempty_ready_lists = (Priority_Bitmap*)Memory_Semantics::shared_calloc(1, sizeof(Priority_Bitmap));
+
      global_sequence_number = (int*)OS_Interface::malloc_uncacheable_shared(sizeof(int), sizeof(int));
     *global_sequence_number = 0;
 
@@ -267,6 +290,9 @@ void Squeak_Interpreter::interpret() {
   assert_message(Header_Type::Shift == 0  &&  Header_Type::Width >= Tag_Size,
          "lots of code, including Oop packing into class headers, and the mem_bits fns on Oops depends on this");
 
+  Sampling_Profiler::start_here();
+  Hardware_Counters::start_here();
+
   Safepoint_Ability sa(false); // about to internalize things
 	internalizeExecutionState();
 	fetchNextBytecode();
@@ -275,8 +301,7 @@ void Squeak_Interpreter::interpret() {
   for (let_one_through();  ; ) {
     if (Max_Number_Of_Cores > 1)
       check_for_multicore_interrupt();
-    if (Collect_Performance_Counters)
-      u_int64 start = OS_Interface::get_cycle_count();
+    const u_int64 start = Performance_Counters::enabled  ?  OS_Interface::get_cycle_count()  :  0;
 
     assert(activeContext_obj()->is_read_write());
 
@@ -1488,6 +1513,8 @@ void Squeak_Interpreter::checkForInterrupts(bool is_safe_to_process_events) {
   interruptCheckCounter = interruptCheckCounterFeedBackReset();
 
   The_Memory_System()->handle_low_space_signals();
+  if (Logical_Core::running_on_main())
+    The_Memory_System()->check_for_finished_background_snapshot();
 
   if (now < lastTick() ||  use_cpu_ms_changed) {
     // ms clock wrapped so correct the nextPollTick
@@ -1495,7 +1522,7 @@ void Squeak_Interpreter::checkForInterrupts(bool is_safe_to_process_events) {
   }
   if (now >= nextPollTick()  &&  is_safe_to_process_events) {
     bool s = successFlag; successFlag = true;
-    The_Interactions.run_primitive(Logical_Core::main_rank, (fn_t)ioProcessEvents_wrapper);
+    The_Interactions.run_primitive(Logical_Core::main_rank, (fn_t)ioProcessEvents_wrapper, false);
     successFlag = s;
     // sets interruptPending if interrupt key pressed
     set_nextPollTick(now + 200);
@@ -1587,6 +1614,8 @@ void Squeak_Interpreter::createActualMessageTo(Oop aClass) {
 
 
 void Squeak_Interpreter::transfer_to_highest_priority(const char* why) {
+  Timeline_Slice ts(Timeline::scheduler, "transfer_to_highest_priority", why);
+  Hardware_Counters_Phase hp(Hardware_Counters::scheduler);
   Scheduler_Mutex sm("transfer_to_highest_priority");  // protect selection and xfer
   if (Print_Scheduler_Verbose) {
     debug_printer->printf("on %d: about to transfer_to_highest_priority %s: ", my_rank(), why);
@@ -1610,6 +1639,84 @@ void Squeak_Interpreter::transfer_to_highest_priority(const char* why) {
 }
 
 
+// Try the processes other cores (or we) just made runnable before walking all the lists.
+// The hint only stands if the process is still waiting, unmoved, in the ready list of its priority.
+bool Squeak_Interpreter::transfer_to_hinted_process() {
+  if (run_queues == NULL  ||  !is_ok_to_run_on_me())
+    return false;
+  Hardware_Counters_Phase hp(Hardware_Counters::scheduler);
+  Oop proc;
+  if (run_queues->take_handoff(my_rank(), proc)) {
+    // a better hint may have come in meanwhile
+    Object_p proc_obj = proc.as_object();
+    if (run_queues->has_hint_above(my_rank(), proc_obj->priority_of_process()))
+      run_queues->push(my_rank(), proc, proc_obj->priority_of_process());
+    else if (transfer_to_hinted_process_if_still_runnable(proc))
+      return true;
+  }
+  while (run_queues->take(my_rank(), proc))
+    if (transfer_to_hinted_process_if_still_runnable(proc))
+      return true;
+  return false;
+}
+
+
+// Run_Queues::take has already dropped the hints that went stale in its queue, without this mutex;
+// this check only catches one that went stale since.
+bool Squeak_Interpreter::transfer_to_hinted_process_if_still_runnable(Oop proc) {
+  Scheduler_Mutex sm("transfer_to_hinted_process");
+  if (!is_hinted_process_still_runnable(proc))
+    return false;
+  Object_p proc_obj = proc.as_object();
+  Object_p processList = proc_obj->process_list_for_priority_of_process();
+  // move to end, as find_and_move_to_end_highest_priority_non_running_process does
+  proc_obj->remove_process_from_scheduler_list("transfer_to_hinted_process");
+  processList->addLastLinkToList(proc);
+  note_ready_list_nonempty(proc_obj->priority_of_process());
+
+  if (Print_Scheduler) {
+    debug_printer->printf("on %d: in transfer_to_hinted_process found: ", my_rank());
+    proc.print_process_or_nil(debug_printer);
+    debug_printer->nl();
+  }
+  PERF_CNT(this, count_run_queue_hits());
+  transferTo(proc, "transfer_to_hinted_process");
+  return true;
+}
+
+
+// Is the process still waiting, unmoved, in the ready list of its priority, and may it run here?
+// Without the Scheduler_Mutex the answer may be out of date, but objects cannot move meanwhile,
+// so reading the fields is safe; called so under a Run_Queues lock to weed out stale hints.
+bool Squeak_Interpreter::is_hinted_process_still_runnable(Oop proc) {
+  Object_p proc_obj = proc.as_object();
+  if (proc_obj->is_process_running()
+  ||  proc_obj->my_list_of_process() != proc_obj->process_list_for_priority_of_process()->as_oop()) {
+    PERF_CNT(this, count_run_queue_stale_hints());
+    return false;
+  }
+  if (!proc_obj->is_process_allowed_to_run_on_this_core()) {
+    // some other core must find it in the lists
+    run_queues->note_dropped_hint();
+    return false;
+  }
+  return true;
+}
+
+
+void Squeak_Interpreter::hint_runnable_process(Object_p proc_obj) {
+  if (run_queues == NULL  ||  proc_obj->my_list_of_process() == roots.nilObj)
+    return;
+  int rank = run_queues->home_rank_of(proc_obj, my_rank());
+  if (!is_ok_to_run_on(rank)  ||  !proc_obj->is_process_allowed_to_run_on(rank))
+    rank = my_rank();
+  run_queues->note_runnable(proc_obj);
+  if (rank != my_rank()  &&  run_queues->hand_off(rank, proc_obj->as_oop()))
+    return;
+  run_queues->push(rank, proc_obj->as_oop(), proc_obj->priority_of_process());
+}
+
+
 void Squeak_Interpreter::resume(Oop aProcess, const char* why) {
   /* I just found a tough bug:
      Resume is called, and it asked all the other cores to do a yield.
@@ -1701,6 +1808,7 @@ void Squeak_Interpreter::put_running_process_to_sleep(const char* why) {
   storeContextRegisters(activeContext_obj()); // xxxxxx redundant maybe with newActiveContext call in start_running
   aProcess.as_object()->set_suspended_context_of_process(activeContext());
   unset_running_process();
+  hint_runnable_process(aProcess.as_object()); // still in its list, so others may pick it up
   if (Print_Scheduler_Verbose) {
     debug_printer->printf("scheduler: on %d, AFTER put_running_process_to_sleep: ", my_rank());
     aProcess.print_process_or_nil(debug_printer);
@@ -2445,6 +2553,59 @@ void Squeak_Interpreter::snapshot(bool /* embedded */) {
 }
 
 
+// Like snapshot, but no GC, and the image is written by a forked child
+// while we keep going; see Memory_System::fork_to_write_image_file.
+// The saved image resumes answering true; here we answer false at once,
+// or the receiver if the fork did not happen, and the semaphore is signalled
+// when the child is done (or right away on failure).
+// Answers false, having changed nothing, if another one is already under way.
+bool Squeak_Interpreter::background_snapshot(int semaphore_index) {
+  Oop r;
+  Oop activeProc = get_running_process();
+  bool started;
+  {
+    Safepoint_for_moving_objects ss("background snapshot");
+    Safepoint_Ability sa(false);
+    // checked again here, since another core may have started one since the primitive looked
+    if (!The_Memory_System()->claim_background_snapshot())
+      return false;
+    r = popStack();
+    pushBool(true);
+    {
+      Scheduler_Mutex sm("background snapshot prep");
+      if (!process_is_scheduled_and_executing())
+        transferTo(activeProc, "background snapshot prep");
+    }
+    {
+      Scheduler_Mutex sm("background snapshot");
+      storeContextRegisters(activeContext_obj());
+      remove_running_process_from_scheduler_lists_and_put_it_to_sleep("background snapshot");
+
+      schedulerPointer_obj()->storePointer(Object_Indices::ActiveProcessIndex, activeProc);
+      assert_active_process_not_nil();
+    }
+    The_Memory_System()->snapshotCleanUp();
+    started = The_Memory_System()->fork_to_write_image_file(semaphore_index);
+    {
+      Scheduler_Mutex sm("background snapshot recovery");
+
+      activeProc.as_object()->add_process_to_scheduler_list();
+      transferTo(activeProc, "background snapshot");
+      if (Check_Prefetch) assert_always(have_executed_currentBytecode);
+    }
+  }
+  activeContext_obj()->beRootIfOld();
+  pop(1);
+  if (started)
+    pushBool(false);
+  else {
+    push(r);
+    signalSemaphoreWithIndex(semaphore_index);
+  }
+  return true;
+}
+
+
 void Squeak_Interpreter::showDisplayBitsOf(Oop aForm, oop_int_t l, oop_int_t t, oop_int_t r, oop_int_t b) {
   if (deferDisplayUpdates()) return;
   displayBitsOf(aForm, l, t, r, b);
@@ -2507,51 +2668,44 @@ Oop Squeak_Interpreter::find_and_move_to_end_highest_priority_non_running_proces
   Scheduler_Mutex sm("find_and_move_to_end_highest_priority_non_running_process");
   // return highest pri ready to run
   // see find_a_process_to_run_and_start_running_it
-  bool verbose = false;
   bool found_a_proc = false;
-  FOR_EACH_READY_PROCESS_LIST(slo, p, processList, this)  {
-
-    if (processList->isEmptyList())
-      continue;
-    found_a_proc = true;
-    if (verbose)
-      lprintf("find_and_move_to_end_highest_priority_non_running_process searching list %d\n", p + 1);
-    Oop  first_proc = processList->fetchPointer(Object_Indices::FirstLinkIndex);
-    Oop   last_proc = processList->fetchPointer(Object_Indices:: LastLinkIndex);
-
-    Oop        proc = first_proc;
-    Object_p proc_obj = proc.as_object();
-    Object_p prior_proc_obj = (Object_p)NULL;
-    for (;;)  {
-      if (verbose) {
-        debug_printer->printf("on %d: find_and_move_to_end_highest_priority_non_running_process proc: ",
-                              my_rank());
-        proc_obj->print_process_or_nil(debug_printer);
-        debug_printer->nl();
-      }
-      OS_Interface::mem_fence(); // xxxxxx Is this fence needed? -- dmu 4/09
-      assert(proc_obj->as_oop() == proc  &&  proc.as_object() == proc_obj);
-      if (proc_obj->is_process_running()  ||  !proc_obj->is_process_allowed_to_run_on_this_core())
-        ;
-      else if (last_proc == proc) {
-         return proc;
-      }
-      else if (first_proc == proc) {
-        processList->removeFirstLinkOfList();
-        processList->addLastLinkToList(proc);
-        return proc;
-      }
-      else {
-        processList->removeMiddleLinkOfList(prior_proc_obj, proc_obj);
-        processList->addLastLinkToList(proc);
-        return proc;
+  Object_p slo = process_lists_of_scheduler();
+  int n = slo->fetchWordLength();
+  if (n <= Priority_Bitmap::max_priorities) {
+    // Only look at the lists the bitmap says are not empty. If that turns up no list at all,
+    // the image may have filled one behind our back, so resync and look again.
+    // Lists with only running processes in them are the usual idle case, so then
+    // resync only now and again, to bound the wait of such a process.
+    for (int tries = 0;  tries < 2;  ++tries) {
+      bool found_a_list = false;
+      for (int p = nonempty_ready_lists->highest_at_or_below(n - 1);
+               p >= 0;
+               p = nonempty_ready_lists->highest_at_or_below(p - 1)) {
+        Object_p processList = slo->fetchPointer(p).as_object();
+        if (processList->isEmptyList()) {
+          nonempty_ready_lists->clear(p);
+          continue;
+        }
+        found_a_proc = found_a_list = true;
+        Oop proc = find_and_move_to_end_non_running_process_in(processList);
+        if (proc != roots.nilObj)
+          return proc;
       }
-      if  (last_proc == proc)
+      if (found_a_list  &&  ++searches_since_resync < max_searches_between_resyncs)
         break;
-
-      prior_proc_obj = proc_obj;
-      proc = proc_obj->fetchPointer(Object_Indices::NextLinkIndex);
-      proc_obj = proc.as_object();
+      searches_since_resync = 0;
+      if (!resync_nonempty_ready_lists())
+        break;
+    }
+  }
+  else {
+    FOR_EACH_READY_PROCESS_LIST(slo, p, processList, this)  {
+      if (processList->isEmptyList())
+        continue;
+      found_a_proc = true;
+      Oop proc = find_and_move_to_end_non_running_process_in(processList);
+      if (proc != roots.nilObj)
+        return proc;
     }
   }
 
@@ -2563,6 +2717,67 @@ Oop Squeak_Interpreter::find_and_move_to_end_highest_priority_non_running_proces
 }
 
 
+Oop Squeak_Interpreter::find_and_move_to_end_non_running_process_in(Object_p processList) {
+  bool verbose = false;
+  Oop  first_proc = processList->fetchPointer(Object_Indices::FirstLinkIndex);
+  Oop   last_proc = processList->fetchPointer(Object_Indices:: LastLinkIndex);
+
+  Oop        proc = first_proc;
+  Object_p proc_obj = proc.as_object();
+  Object_p prior_proc_obj = (Object_p)NULL;
+  for (;;)  {
+    if (verbose) {
+      debug_printer->printf("on %d: find_and_move_to_end_highest_priority_non_running_process proc: ",
+                            my_rank());
+      proc_obj->print_process_or_nil(debug_printer);
+      debug_printer->nl();
+    }
+    OS_Interface::mem_fence(); // xxxxxx Is this fence needed? -- dmu 4/09
+    assert(proc_obj->as_oop() == proc  &&  proc.as_object() == proc_obj);
+    if (proc_obj->is_process_running()  ||  !proc_obj->is_process_allowed_to_run_on_this_core())
+      ;
+    else if (last_proc == proc) {
+       return proc;
+    }
+    else if (first_proc == proc) {
+      processList->removeFirstLinkOfList();
+      processList->addLastLinkToList(proc);
+      return proc;
+    }
+    else {
+      processList->removeMiddleLinkOfList(prior_proc_obj, proc_obj);
+      processList->addLastLinkToList(proc);
+      return proc;
+    }
+    if  (last_proc == proc)
+      break;
+
+    prior_proc_obj = proc_obj;
+    proc = proc_obj->fetchPointer(Object_Indices::NextLinkIndex);
+    proc_obj = proc.as_object();
+  }
+  return roots.nilObj;
+}
+
+
+// Answers whether a list was found that the bitmap did not know about
+bool Squeak_Interpreter::resync_nonempty_ready_lists() {
+  assert(Scheduler_Mutex::is_held());
+  bool found_new = false;
+  FOR_EACH_READY_PROCESS_LIST(slo, p, processList, this)  {
+    if (p >= Priority_Bitmap::max_priorities)
+      continue;
+    if (processList->isEmptyList())
+      nonempty_ready_lists->clear(p);
+    else if (!nonempty_ready_lists->is_set(p)) {
+      nonempty_ready_lists->set(p);
+      found_new = true;
+    }
+  }
+  return found_new;
+}
+
+
 int Squeak_Interpreter::count_processes_in_scheduler() {
   Scheduler_Mutex sm("find_and_move_to_end_highest_priority_non_running_process");
   // return highest pri ready to run
@@ -2811,8 +3026,7 @@ void Squeak_Interpreter::multicore_interrupt() {
   if (Message_Queue::are_data_available(my_core()))
     PERF_CNT(this, count_data_available());
 
-  if (Collect_Performance_Counters)
-    const u_int64 start = OS_Interface::get_cycle_count();
+  const u_int64 start = Performance_Counters::enabled  ?  OS_Interface::get_cycle_count()  :  0;
 
 
   multicore_interrupt_check = false;
@@ -2822,6 +3036,9 @@ void Squeak_Interpreter::multicore_interrupt() {
     internal_undo_prefetch();
     externalizeExecutionState();
   }
+
+  if (Sampling_Profiler::is_supported()  &&  Sampling_Profiler::here() != NULL  &&  Sampling_Profiler::here()->needs_draining())
+    Sampling_Profiler::here()->drain();
   
   {
     Safepoint_Ability sa(true);
@@ -2869,13 +3086,37 @@ void Squeak_Interpreter::multicore_interrupt() {
 
 
 void Squeak_Interpreter::try_to_find_a_process_to_run_and_start_running_it() {
-  minimize_scheduler_mutex_load_by_spinning_till_there_might_be_a_runnable_process();
-  transfer_to_highest_priority("find_a_process_to_run_and_start_running_it");
-  assert_method_is_correct_internalizing(true, "after transfer_to_highest_priority");
+  if (transfer_to_hinted_process())
+    return;
+  bool forced = minimize_scheduler_mutex_load_by_spinning_till_there_might_be_a_runnable_process();
+  if (transfer_to_hinted_process())
+    return;
+  if (must_walk_process_lists(forced)) {
+    transfer_to_highest_priority("find_a_process_to_run_and_start_running_it");
+    assert_method_is_correct_internalizing(true, "after transfer_to_highest_priority");
+  }
+}
+
+
+// With run queues, every process the VM makes runnable gets a hint, so an idle core that
+// finds no hint need not take the Scheduler_Mutex to walk all the lists, unless a hint was lost,
+// an interrupt check was forced, or it has not walked them for a while.
+bool Squeak_Interpreter::must_walk_process_lists(bool forced) {
+  if (run_queues == NULL)
+    return true;
+  int epoch = run_queues->get_dropped_hints_epoch();
+  if (   !forced
+      &&  epoch == last_dropped_hints_epoch
+      &&  ++wakeups_since_walking_process_lists < max_wakeups_between_walks)
+    return false;
+  last_dropped_hints_epoch = epoch;
+  wakeups_since_walking_process_lists = 0;
+  return true;
 }
 
 
-void Squeak_Interpreter::minimize_scheduler_mutex_load_by_spinning_till_there_might_be_a_runnable_process() {
+// Returns true if it stopped because an interrupt check was forced
+bool Squeak_Interpreter::minimize_scheduler_mutex_load_by_spinning_till_there_might_be_a_runnable_process() {
   uint32_t busyWaitCount = 0;
   do {
     safepoint_tracker->spin_if_safepoint_requested(); // since we are about to wait for a message
@@ -2895,14 +3136,18 @@ void Squeak_Interpreter::minimize_scheduler_mutex_load_by_spinning_till_there_mi
   } while (
               added_process_count < 1 /* there are no new procs to run */
               && nextPollTick() != 0     /* forceInterruptCheck was not called */
+              && (run_queues == NULL  ||  !run_queues->might_have_a_hint_for(my_rank()))
            ); 
   if (added_process_count) --added_process_count;
+  return nextPollTick() == 0;
 }
 
 
 
 // STEFAN: think we should try to sleep here and avoid busy waiting too much
 // DAVID: the problem is that the sleeps won't wake up if the core receives a request message
+// With threads, helpers now park instead, and every message send unparks the receiver;
+// main still sleeps in ioRelinquishProcessorForMicroseconds, since it also waits for OS events.
 
 void Squeak_Interpreter::give_up_CPU_instead_of_spinning(uint32_t& busyWaitCount) {
   busyWaitCount++;
@@ -2920,11 +3165,36 @@ void Squeak_Interpreter::give_up_CPU_instead_of_spinning(uint32_t& busyWaitCount
   static const u_int32 max_sleep_usecs = 500; // experimentally determined on Mac by watching Kiviats, etc -- dmu 10/1/10
   if (Logical_Core::running_on_main())
     ioRelinquishProcessorForMicroseconds(min(max_sleep_usecs, sleep));
-  else 
+  else if (Using_Threads)
+    park_till_there_might_be_work();
+  else
     usleep(min(max_sleep_usecs, sleep));
 }
 
 
+// Messages (including addedScheduledProcessMessage), hints pushed to our run queue or to a busy
+// core's, and forceInterruptCheck wake us. We also wake when a hint on another core becomes
+// old enough to steal; the longest sleep, a backstop, is that of the usleep parking replaced.
+void Squeak_Interpreter::park_till_there_might_be_work() {
+  static const u_int64 max_park_usecs = 500;
+  Logical_Core* me = my_core();
+  if (run_queues != NULL)
+    run_queues->open_handoff_slot(my_rank());
+  me->announce_parking();
+  u_int64 usecs = max_park_usecs;
+  if (run_queues != NULL)
+    usecs = min(usecs, run_queues->nsecs_till_a_hint_ripens(my_rank()) / 1000  +  1);
+  if (   added_process_count > 0
+      || Message_Queue::are_data_available(me)
+      || (run_queues != NULL  &&  run_queues->might_have_a_hint_for(my_rank())))
+    me->stop_parking();
+  else
+    me->park(int(usecs));
+  if (run_queues != NULL)
+    run_queues->close_handoff_slot(my_rank());
+}
+
+
 void Squeak_Interpreter::fixup_localIP_after_being_transferred_to() {
   if (process_is_scheduled_and_executing()) {
     internalizeExecutionState();
@@ -2939,6 +3209,7 @@ void Squeak_Interpreter::move_mutated_read_mostly_objects() {
   if (mutated_read_mostly_objects_count == 0)
     return;
 
+  Timeline_Slice ts(Timeline::replication, "move_mutated_read_mostly_objects");
   Safepoint_for_moving_objects sf("move_mutated_read_mostly_objects");
   Safepoint_Ability sa(false);
 
@@ -2974,7 +3245,24 @@ void Squeak_Interpreter::run_primitive_on_main_from_elsewhere(fn_t f) {
 }
 
 
-void Squeak_Interpreter::dispatchFunctionPointer(fn_t f, bool on_main) {
+// On main, after an asynchronous remote primitive, with the caller's process filled in:
+// do what the caller would have done on failure, then leave the process runnable.
+// put_running_process_to_sleep hints it to the core it came from.
+void Squeak_Interpreter::finish_asynchronous_remote_primitive() {
+  assert_on_main();
+  if (!process_is_scheduled_and_executing())
+    return; // the primitive put it to sleep itself
+  if (!successFlag)
+    activateNewMethod();
+  put_running_process_to_sleep("finish_asynchronous_remote_primitive");
+  if (run_queues == NULL)
+    addedScheduledProcessMessage_class().send_to_other_cores();
+}
+
+
+// may_suspend_caller: the caller will return straight to the interpreter, so an asynchronous
+// remote primitive may leave this core running another process. -- see Interactions::run_primitive
+void Squeak_Interpreter::dispatchFunctionPointer(fn_t f, bool on_main, bool may_suspend_caller) {
   assert_method_is_correct_internalizing(true, "start of dispatchFunctionPointer");
   
   
@@ -2989,14 +3277,18 @@ void Squeak_Interpreter::dispatchFunctionPointer(fn_t f, bool on_main) {
 
   PERF_CNT(this, count_primitive_invokations());
   
+  const int outer_primitive_index = running_primitive_index;
+  running_primitive_index = primitiveIndex;
+
   if (on_main) {
-    The_Interactions.run_primitive(Logical_Core::main_rank, f);
+    The_Interactions.run_primitive(Logical_Core::main_rank, f, may_suspend_caller);
     assert_method_is_correct_internalizing(true, "after run_primitive_on_main");
   }
   else {
     (*f)();
     assert_method_is_correct_internalizing(true, "end of dispatchFunctionPointer");
   }
+  running_primitive_index = outer_primitive_index;
   
 # if Dont_Dump_Primitive_Cycles && Dump_Bytecode_Cycles
   --recurse;
@@ -3034,6 +3326,8 @@ void Squeak_Interpreter::booleanCheat(bool cond) {
 
 void Squeak_Interpreter::transferTo(Oop newProc, const char* why) {
   if (check_many_assertions) assert(!newProc.as_object()->is_process_running());
+  if (timeline != NULL)
+    timeline->instant(Timeline::scheduler, "switch process", why);
 
   Scheduler_Mutex sm("transferTo"); // in case another cpu starts running this
   if (Print_Scheduler_Verbose) {
@@ -3235,11 +3529,13 @@ Object_p Squeak_Interpreter::allocateOrRecycleContext(bool needsLarge) {
       
       if (check_many_assertions  &&  r->get_count_of_blocks_homed_to_this_method_ctx() > 0)
         lprintf("RECYCLING recycled live one 0x%x, method 0x%x\n", r->as_oop().bits(), r->fetchPointer(Object_Indices::MethodIndex).bits());
+      PERF_CNT(this, count_contexts_recycled());
       return r;
     }
   }
 
   // xxxxxxxx optimize spl objects by replicating the special objects array someday -- dmu 4/09
+  PERF_CNT(this, count_contexts_allocated());
   Object_p class_method_context = splObj_obj(Special_Indices::ClassMethodContext);
   const int lcs = Object_Indices::LargeContextSize; // this and next needed for C++ bug
   const int scs = Object_Indices::SmallContextSize;
@@ -3547,7 +3843,7 @@ void Squeak_Interpreter::receive_initial_interpreter_from_main(Squeak_Interprete
   *((Logical_Core**)coreAddr) = my_core;
 #endif
   
-  safepoint_tracker = new Safepoint_Tracker();
+  safepoint_tracker = new Safepoint_Tracker(safepoint_epochs); // shared, copied from main above
   safepoint_master_control = NULL;
   safepoint_ability = sa;
 
@@ -3613,6 +3909,10 @@ void Squeak_Interpreter::preGCAction_here(bool fullGC) {
   if (process_is_scheduled_and_executing())
     storeContextRegisters(activeContext_obj());
   if (fullGC)   flushInterpreterCaches();
+  if (fullGC  &&  coalesced_broadcasts != NULL)
+    coalesced_broadcasts->drop_pending_flushes_here();
+  if (Sampling_Profiler::is_supported()  &&  Sampling_Profiler::here() != NULL)
+    Sampling_Profiler::here()->drain(); // names its samples while their Oops are still good
   if (print) print_method_info(fullGC ? "post preGCAction_here fullGC" : "pre preGCAction_here !fullGC");
 }
 
@@ -3620,6 +3920,14 @@ void Squeak_Interpreter::preGCAction_here(bool fullGC) {
 void Squeak_Interpreter::postGCAction_here(bool fullGC) {
   const bool print = false;
   sync_with_roots();
+  if (run_queues != NULL  &&  !fullGC)
+    run_queues->drop_hints_of(my_rank()); // objects may have moved; a full GC has dropped all hints itself
+  if (Sampling_Profiler::is_supported()  &&  Sampling_Profiler::here() != NULL)
+    Sampling_Profiler::here()->objects_have_moved();
+  if (Allocation_Profiler::is_supported()  &&  Allocation_Profiler::here() != NULL)
+    Allocation_Profiler::here()->objects_have_moved();
+  if (fullGC  &&  Allocation_Profiler::census_after_gc)
+    Allocation_Profiler::take_census_here();
   if (process_is_scheduled_and_executing()) {
     // next line is for assertions only, 
     // because none of the routines called below can receive a message -- dmu 7/12/10
@@ -3688,11 +3996,27 @@ void Squeak_Interpreter::broadcast_bool(bool* d) {
 
 
 void Squeak_Interpreter::broadcast_datum(int datum_size, void* datum_addr, u_int64 datum) {
+  if (coalesced_broadcasts != NULL) {
+    coalesced_broadcasts->broadcast_datum(datum_size, (char*)datum_addr - (char*)this, datum);
+    return;
+  }
   broadcastInterpreterDatumMessage_class m(datum_size, (char*)datum_addr - (char*)this, datum);
   m.send_to_other_cores();
 }
 
 
+void Squeak_Interpreter::store_broadcast_datum(int datum_size, int datum_byte_offset, u_int64 datum) {
+  void* p = (char*)this + datum_byte_offset;
+  assert_always(p < (void*)(this + 1));
+  switch (datum_size) {
+    default: fatal();
+    case sizeof(   char): *(   char*)p = (char)datum;  break;
+    case sizeof(    int): *(    int*)p = ( int)datum;  break;
+    case sizeof(u_int64): *(u_int64*)p =       datum;  break;
+  }
+}
+
+
 
 void Squeak_Interpreter::distribute_initial_interpreter() {
   Safepoint_Ability sa(false);
@@ -3700,6 +4024,10 @@ void Squeak_Interpreter::distribute_initial_interpreter() {
   assert_always(Logical_Core::running_on_main());
   // lprintf("main about to distribute interpreter\n");
   if (check_assertions)  roots.specialObjectsOop.verify_object();
+
+  // Only now, so that no core can get an applyPendingBroadcastsMessage before it has the pointer
+  if (Coalesced_Broadcasts::use_coalesced_broadcasts)
+    coalesced_broadcasts = Coalesced_Broadcasts::create();
   
   // Use a shared buffer to reduce the size of the message to optimize the footprint of message buffer allocation -- dmu & sm
   Squeak_Interpreter* interp_shared_copy = (Squeak_Interpreter*)Memory_Semantics::shared_malloc(sizeof(Squeak_Interpreter));  
@@ -131,6 +131,9 @@ private:
   void broadcast_int32(int32* w);
   void broadcast_bool(bool* b);
   void broadcast_datum(int size, void* p, u_int64 d);
+public:
+  void store_broadcast_datum(int size, int offset, u_int64 d);
+private:
   
 public:  
 
@@ -251,8 +254,15 @@ public:
   
   Safepoint_Tracker* safepoint_tracker;
   Safepoint_Master_Control* safepoint_master_control;
+  Safepoint_Epochs* safepoint_epochs; // shared; NULL when safepoints go through Safepoint_Master_Control
+  Safepoint_Stats*  safepoint_stats;  // shared
   Safepoint_Ability *safepoint_ability;
 
+  Run_Queues* run_queues; // shared by all cores, NULL if -no_run_queues
+  Coalesced_Broadcasts* coalesced_broadcasts; // shared by all cores, NULL if -no_coalesced_broadcasts
+  Timeline* timeline; // shared by all cores, NULL unless -timeline
+  Priority_Bitmap* nonempty_ready_lists; // shared; a set bit may be stale, a clear one only if the image changed the lists itself
+
 
   u_char*   _localIP;  
   Oop*      _localSP;
@@ -359,6 +369,7 @@ public:
 
 
   oop_int_t primitiveIndex;
+  int running_primitive_index; // primitiveIndex while its primitive runs, else 0; for Sampling_Profiler
 
 
 
@@ -1156,8 +1167,11 @@ public:
 
   bool lookupInMethodCacheSel(Oop msgSel, Oop klass) {
     Method_Cache::entry* e = methodCache.at(msgSel, klass);
-    if (e == NULL)
+    if (e == NULL) {
+      PERF_CNT(this, count_method_cache_misses());
       return false;
+    }
+    PERF_CNT(this, count_method_cache_hits());
     roots.newMethod = e->method;
     primitiveIndex = e->prim;
     roots.newNativeMethod = e->native;
@@ -1307,7 +1321,8 @@ public:
 
   
   void run_primitive_on_main_from_elsewhere(fn_t);
-  void dispatchFunctionPointer(fn_t f, bool on_main);
+  void dispatchFunctionPointer(fn_t f, bool on_main, bool may_suspend_caller = true);
+  void finish_asynchronous_remote_primitive();
   void dispatchFunctionPointer(int i, Primitive_Table *pt) {
     dispatchFunctionPointer(pt->contents[i], pt->execute_on_main[i]);
   }
@@ -1349,6 +1364,7 @@ public:
   void forceInterruptCheck() {
     interruptCheckCounter = interruptCheckCounter_force_value;
     set_nextPollTick(0);
+    Logical_Core::unpark_all_others(); // idle cores wait for nextPollTick to be 0, too
   }
 
   void createActualMessageTo(Oop);
@@ -1516,6 +1532,10 @@ public:
   void checkForInterrupts(bool is_safe_to_process_events = true);
 
   void transfer_to_highest_priority(const char*);
+  bool transfer_to_hinted_process();
+  bool transfer_to_hinted_process_if_still_runnable(Oop);
+  bool is_hinted_process_still_runnable(Oop);
+  void hint_runnable_process(Object_p);
 
   void resume(Oop, const char*);
   void yield(const char*);
@@ -1553,6 +1573,14 @@ public:
   void transferTo(Oop newProc, const char* why);
   void start_running(Oop newProc, const char*);
   Oop  find_and_move_to_end_highest_priority_non_running_process();
+  Oop  find_and_move_to_end_non_running_process_in(Object_p processList);
+  bool resync_nonempty_ready_lists();
+  int  searches_since_resync;
+  static const int max_searches_between_resyncs = 64; // when all the listed processes are running
+  void note_ready_list_nonempty(int priority) {
+    if (nonempty_ready_lists != NULL  &&  1 <= priority  &&  priority <= Priority_Bitmap::max_priorities)
+      nonempty_ready_lists->set(priority - 1);
+  }
   int count_processes_in_scheduler();
 
   void newActiveContext(Oop aContext, Object_p aContext_obj);
@@ -1724,6 +1752,7 @@ public:
   }
 
   void snapshot(bool);
+  bool background_snapshot(int semaphore_index);
   void snapshotCleanUp();
 
   void     displayBitsOf(Oop, oop_int_t, oop_int_t, oop_int_t, oop_int_t);
@@ -1825,16 +1854,23 @@ public:
     // xxxxxx If set multicore_interrupt_check whenever yield_requested() 
     //        will be true, could speed up this test.
     // -- dmu 4/09
-    if (multicore_interrupt_check || yield_requested() || Message_Queue::are_data_available(my_core()))
+    // A shared-memory safepoint request sends no message, so look for it, too.
+    if (multicore_interrupt_check || yield_requested() || Message_Queue::are_data_available(my_core())
+    ||  safepoint_tracker->is_shared_memory_safepoint_requested())
        multicore_interrupt();
   }
 
   void multicore_interrupt();
   void try_to_find_a_process_to_run_and_start_running_it();
-  void minimize_scheduler_mutex_load_by_spinning_till_there_might_be_a_runnable_process();
+  bool minimize_scheduler_mutex_load_by_spinning_till_there_might_be_a_runnable_process();
+  bool must_walk_process_lists(bool forced);
+  int last_dropped_hints_epoch;
+  int wakeups_since_walking_process_lists;
+  static const int max_wakeups_between_walks = 16; // bounds the wait of processes the image made runnable behind our back
 
   
   void give_up_CPU_instead_of_spinning(uint32_t&);
+  void park_till_there_might_be_work();
   void fixup_localIP_after_being_transferred_to();
  private:
   void move_mutated_read_mostly_objects();
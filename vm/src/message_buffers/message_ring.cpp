@@ -0,0 +1,158 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ * 
+ *  Contributors:
+ *    Stefan Marr, Vrije Universiteit Brussel - Initial Implementation
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <assert.h>
+#include <sys/mman.h>
+
+#include "message_ring.h"
+
+
+MessageRing::MessageRing(size_t cap)
+: reserved(0), released(0),
+  read_position(0), release_position(0),
+  buffer(map_buffer(cap)),
+  capacity(cap),
+  publish_interval(cap / 16)
+{
+  assert(cap  &&  (cap & (cap - 1)) == 0);
+  assert(cap % alignment == 0);
+}
+
+
+MessageRing::~MessageRing() {
+  munmap(buffer, capacity);
+}
+
+
+// Zero filled, as records must start out cleared.
+char* MessageRing::map_buffer(size_t cap) {
+  void* p = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    perror("MessageRing buffer");
+    abort();
+  }
+  return (char*)p;
+}
+
+
+void MessageRing::await_room_till(uint32_t end) const {
+  // unsigned arithmetic takes care of the wrap around
+  for (uint32_t tries = 0;  uint32_t(end - released) > capacity;  ++tries) {
+    __sync_synchronize();
+    if (tries >= max_spins_before_yielding)
+      sched_yield(); // the receiver may be sharing our CPU
+  }
+}
+
+
+void MessageRing::skip_over(uint32_t position, uint32_t length) {
+  record* r = record_at(position);
+  r->size = 0;
+  __sync_synchronize();
+  r->length = -int32_t(length);
+}
+
+
+void MessageRing::send(const void* data, size_t size) {
+  assert(size <= max_message_size());
+  const uint32_t length = record_length_for(size);
+
+  for (;;) {
+    const uint32_t start = __sync_fetch_and_add(&reserved, length);
+    await_room_till(start + length);
+
+    const uint32_t offset = start & (capacity - 1);
+    if (offset + length <= capacity) {
+      record* r = record_at(start);
+      memcpy(r->data, data, size);
+      r->size = int32_t(size);
+      __sync_synchronize(); // contents before length
+      r->length = int32_t(length);
+      return;
+    }
+    // would straddle the end: give it back as two skips, and try again
+    const uint32_t tail = capacity - offset;
+    skip_over(start, tail);
+    skip_over(start + tail, length - tail);
+  }
+}
+
+
+bool MessageRing::hasData() {
+  for (;;) {
+    record* r = record_at(read_position);
+    int32_t length = r->length;
+    if (length > 0)
+      return true;
+    if (length == 0) {
+      // ran dry: senders may be waiting for the last batch
+      if (release_position == read_position  &&  released != release_position)
+        publish_release();
+      return false;
+    }
+    // a skip; if nothing before it is still being used, free it right away
+    bool can_release = release_position == read_position;
+    read_position += uint32_t(-length);
+    if (can_release) {
+      memset(r, 0, -length);
+      release_position = read_position;
+    }
+  }
+}
+
+
+const void* MessageRing::receive(size_t& size) {
+  for (uint32_t tries = 0;  !hasData();  ++tries)
+    if (tries >= max_spins_before_yielding)
+      sched_yield();
+  __sync_synchronize(); // length before contents
+
+  record* r = record_at(read_position);
+  read_position += uint32_t(r->length);
+  size = size_t(r->size);
+  return r->data;
+}
+
+
+void MessageRing::releaseOldest(void* buffer_to_be_released_for_debugging) {
+  // the record, and any skips around it that the receiver has passed
+  bool released_message = false;
+  while (release_position != read_position) {
+    record* r = record_at(release_position);
+    int32_t length = r->length;
+    assert(length != 0);
+    if (length > 0) {
+      if (released_message)
+        break;
+      assert((void*)r->data == buffer_to_be_released_for_debugging);
+      released_message = true;
+    }
+    else
+      length = -length;
+
+    memset(r, 0, length);
+    release_position += uint32_t(length);
+  }
+  assert(released_message);
+  if (uint32_t(release_position - released) >= publish_interval)
+    publish_release();
+}
+
+
+void MessageRing::publish_release() {
+  __sync_synchronize(); // cleared records before telling senders
+  released = release_position;
+}
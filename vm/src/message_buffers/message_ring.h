@@ -0,0 +1,91 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ * 
+ *  Contributors:
+ *    Stefan Marr, Vrije Universiteit Brussel - Initial Implementation
+ *
+ *
+ *  Multi-writer, single-reader ring of variable-size messages, one per receiver.
+ *  Replaces BufferedChannel's three syncedqueues of fixed-size buffer indices:
+ *
+ *  - A sender reserves room for its record with a single fetch-and-add on
+ *    `reserved', copies the message in place, and then sets the record's
+ *    length, which tells the receiver it is complete.
+ *  - The receiver hands out messages in place, and clears each record on
+ *    release. It tells the senders how far it has got (`released') only
+ *    every publish_interval bytes, or when it runs dry, so that senders and
+ *    receiver do not fight over that cache line for every message.
+ *  - reserved, released and the receiver's own state are each aligned to a
+ *    cache line of their own, so a ring that lives in an array or another
+ *    object must be allocated with that alignment.
+ *
+ *  Positions are byte counts since creation; they wrap around 2^32, which is
+ *  fine as long as the capacity is a power of two below that.
+ *  A record that would straddle the end of the buffer is turned into
+ *  skip records, and the sender reserves again.
+ *  A sender waits, spinning, while the ring is full.
+ *  The buffer is an anonymous mapping of its own: page-aligned, zero, and
+ *  not touched till the first message, so it can be bound to the receiver's node.
+ *
+ ******************************************************************************/
+
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef __MESSAGE_RING_H__
+#define __MESSAGE_RING_H__
+
+class MessageRing {
+private:
+  static const size_t cache_line_size = 64;
+  static const size_t alignment = 8;
+  static const uint32_t max_spins_before_yielding = 1000;
+
+  typedef struct record {
+    volatile int32_t length; // of the whole record, 0 till complete, negative to skip
+    int32_t          size;   // of the message
+    char             data[0];
+  } record;
+
+  // The aligned attribute rounds the size of the ring up to whole lines, too,
+  // so that nothing after it shares the receiver's line.
+  volatile uint32_t reserved  __attribute__((aligned(cache_line_size)));  // senders: end of the last reservation
+  volatile uint32_t released  __attribute__((aligned(cache_line_size)));  // receiver: everything before is free again
+
+  // receiver only
+  uint32_t read_position  __attribute__((aligned(cache_line_size)));  // next record to receive
+  uint32_t release_position;  // next record to release
+  char* const    buffer;
+  const uint32_t capacity;
+  const uint32_t publish_interval;
+
+  record* record_at(uint32_t position) const { return (record*)&buffer[position & (capacity - 1)]; }
+  static uint32_t record_length_for(size_t size) {
+    return (sizeof(record) + size + alignment - 1)  &  ~(alignment - 1);
+  }
+  static char* map_buffer(size_t capacity);
+  void await_room_till(uint32_t end) const;
+  void skip_over(uint32_t position, uint32_t length);
+  void publish_release();
+
+public:
+  // capacity must be a power of two
+  MessageRing(size_t capacity);
+  ~MessageRing();
+
+  void send(const void* data, size_t size);
+  const void* receive(size_t& size);
+  void releaseOldest(void*);
+  bool hasData();
+
+  size_t max_message_size() const { return capacity / 4  -  sizeof(record); }
+  void*  storage() const { return buffer; }
+  size_t storage_size() const { return capacity; }
+};
+
+#endif
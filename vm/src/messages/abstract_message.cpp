@@ -56,6 +56,10 @@ void abstractMessage_class::send_to(int r) {
   assert_always(r != Logical_Core::my_rank()); // should not get here
   if (get_safepoint_delay_setting() == delay_when_have_acquired_safepoint  &&  !Safepoint_Ability::is_interpreter_able()) 
     fatal("Deadlock possible: I may wait for this message to be handled, but if the other core is trying to safepoint, I won't allow it to");
+
+  Coalesced_Broadcasts* const cb = The_Squeak_Interpreter()->coalesced_broadcasts;
+  if (cb != NULL  &&  get_message_type() != Message_Statics::applyPendingBroadcastsMessage)
+    cb->before_direct_send_to(r);
   
 # if Checksum_Messages
   checksum = compute_checksum();
@@ -66,7 +70,14 @@ void abstractMessage_class::send_to(int r) {
 # endif
   
   assert(r < Max_Number_Of_Cores);
+  const char* const name = Message_Statics::message_names[get_message_type()];
+  Timeline_Slice ts(Timeline::message, name);
+  Hardware_Counters_Phase hp(Hardware_Counters::messaging);
+  Timeline* const timeline = The_Squeak_Interpreter()->timeline;
+  timeline_flow_id = timeline == NULL  ?  0  :  timeline->flow_start(Timeline::message, name);
+
   logical_cores[r].message_queue.send_message(this);
+  logical_cores[r].unpark();
   if (should_ack( false, r)
       ||  should_ack(  true, r))
     Message_Statics::wait_for_ack(header, r);
@@ -118,6 +129,11 @@ void abstractMessage_class::handle_me_or_maybe_delay() {
       &&  The_Squeak_Interpreter()->safepoint_tracker->have_acquired_safepoint()) 
     defer_till_done_with_safepoint(); 
   else  { 
+    const char* const name = Message_Statics::message_names[get_message_type()];
+    Timeline_Slice ts(Timeline::message, name);
+    Hardware_Counters_Phase hp(Hardware_Counters::messaging);
+    if (timeline_flow_id != 0  &&  The_Squeak_Interpreter()->timeline != NULL)
+      The_Squeak_Interpreter()->timeline->flow_finish(Timeline::message, name, timeline_flow_id);
     u_int64 start = OS_Interface::get_cycle_count(); 
     handle_me(); 
     u_int64 end = OS_Interface::get_cycle_count();
@@ -27,7 +27,7 @@ protected:
   void defer_till_done_with_safepoint();
   
 public:
-  abstractMessage_class(                ) { sender = cpu_core_my_rank(); }
+  abstractMessage_class(                ) { sender = cpu_core_my_rank();  timeline_flow_id = 0; }
   abstractMessage_class( Receive_Marker*) { }
   virtual void send_to(int);
   virtual Message_Statics::messages get_message_type() const = 0;
@@ -41,6 +41,7 @@ public:
   
   Message_Statics::messages header;
   int sender;
+  int timeline_flow_id; // 0 unless there is a Timeline
   
   
 # if Checksum_Messages
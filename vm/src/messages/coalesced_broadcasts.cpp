@@ -0,0 +1,185 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+#include "headers.h"
+
+bool Coalesced_Broadcasts::use_coalesced_broadcasts = true;
+
+
+Coalesced_Broadcasts* Coalesced_Broadcasts::create() {
+  return (Coalesced_Broadcasts*)Memory_Semantics::shared_calloc(1, sizeof(Coalesced_Broadcasts));
+}
+
+
+void Coalesced_Broadcasts::broadcast_flush(Oop key, bool is_method, bool all) {
+  Method_Cache& mc = The_Squeak_Interpreter()->methodCache;
+  if (all)             mc.flush_method_cache();
+  else if (is_method)  mc.flushByMethod(key);
+  else                 mc.flushSelective(key);
+
+  FOR_ALL_OTHER_RANKS(r)
+    if (add_flush_from(Logical_Core::my_rank(), r, key, is_method, all))
+      schedule(r);
+}
+
+
+bool Coalesced_Broadcasts::add_flush_from(int sender, int rank, Oop key, bool is_method, bool all) {
+  Batch* b = &batches[rank];
+  lock(b);
+  bool coalesced = b->flush_all;
+  for (int i = 0;  !coalesced  &&  !all  &&  i < b->flush_count;  ++i)
+    coalesced = b->flush_keys[i] == key  &&  b->flush_key_is_method[i] == is_method;
+
+  if (coalesced)
+    ;
+  else if (all  ||  b->flush_count == flush_threshold)
+    b->flush_all = true;
+  else {
+    b->flush_keys[b->flush_count] = key;
+    b->flush_key_is_method[b->flush_count] = is_method;
+    ++b->flush_count;
+  }
+  bool must_schedule = join(b, sender, rank);
+  unlock(b);
+
+  if (coalesced)
+    OS_Interface::atomic_fetch_and_add(&broadcasts_coalesced, 1);
+  return must_schedule;
+}
+
+
+void Coalesced_Broadcasts::broadcast_datum(int size, int offset, u_int64 datum) {
+  FOR_ALL_OTHER_RANKS(r) {
+    bool must_schedule;
+    if (add_datum_from(Logical_Core::my_rank(), r, size, offset, datum, &must_schedule)) {
+      if (must_schedule)
+        schedule(r);
+    }
+    else
+      broadcastInterpreterDatumMessage_class(size, offset, datum).send_to(r); // batch is full; before_direct_send_to keeps it after the batch
+  }
+}
+
+
+// A later value for the same field replaces the pending one.
+bool Coalesced_Broadcasts::add_datum_from(int sender, int rank, int size, int offset, u_int64 datum, bool* must_schedule) {
+  Batch* b = &batches[rank];
+  lock(b);
+  int i;
+  for (i = 0;  i < b->datum_count  &&  b->datum_offsets[i] != offset;  ++i)
+    ;
+  bool coalesced = i < b->datum_count;
+  if (!coalesced  &&  i == max_data) {
+    unlock(b);
+    *must_schedule = false;
+    return false;
+  }
+  if (!coalesced) {
+    b->datum_offsets[i] = offset;
+    ++b->datum_count;
+  }
+  b->datum_sizes[i] = size;
+  b->data[i] = datum;
+  *must_schedule = join(b, sender, rank);
+  unlock(b);
+
+  if (coalesced)
+    OS_Interface::atomic_fetch_and_add(&broadcasts_coalesced, 1);
+  return true;
+}
+
+
+// Called with the batch locked, after adding to it. Answers whether sender must schedule it.
+// If another core has, that core's message may be handled after sender's later ones,
+// so sender owes the receiver a message of its own. -- see before_direct_send_to
+bool Coalesced_Broadcasts::join(Batch* b, int sender, int rank) {
+  if (!b->is_scheduled) {
+    b->is_scheduled = true;
+    b->scheduled_by = sender;
+    owed_applies[sender].to[rank] = false;
+    return true;
+  }
+  if (b->scheduled_by != sender)
+    owed_applies[sender].to[rank] = true;
+  return false;
+}
+
+
+bool Coalesced_Broadcasts::take_owed_apply(int sender, int rank) {
+  if (!owed_applies[sender].to[rank])
+    return false;
+  owed_applies[sender].to[rank] = false;
+  return true;
+}
+
+
+void Coalesced_Broadcasts::schedule(int rank) {
+  OS_Interface::atomic_fetch_and_add(&messages_sent, 1);
+  applyPendingBroadcastsMessage_class().send_to(rank);
+}
+
+
+// Keeps each sender's messages in order: whatever this core added to rank's batch
+// is applied before the message it is about to send there.
+// If the batch has been applied already, the extra message finds it empty, or newer.
+void Coalesced_Broadcasts::before_direct_send_to(int rank) {
+  if (take_owed_apply(Logical_Core::my_rank(), rank))
+    schedule(rank);
+}
+
+
+void Coalesced_Broadcasts::apply_pending_here() {
+  Batch* b = &batches[Logical_Core::my_rank()];
+  Batch taken;
+  lock(b);
+  taken.flush_all   = b->flush_all;
+  taken.flush_count = b->flush_count;
+  for (int i = 0;  i < b->flush_count;  ++i) {
+    taken.flush_keys[i] = b->flush_keys[i];
+    taken.flush_key_is_method[i] = b->flush_key_is_method[i];
+  }
+  taken.datum_count = b->datum_count;
+  for (int i = 0;  i < b->datum_count;  ++i) {
+    taken.datum_sizes[i]   = b->datum_sizes[i];
+    taken.datum_offsets[i] = b->datum_offsets[i];
+    taken.data[i]          = b->data[i];
+  }
+  b->flush_all = false;
+  b->flush_count = b->datum_count = 0;
+  b->is_scheduled = false;
+  unlock(b);
+
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (taken.flush_all)
+    interp->methodCache.flush_method_cache();
+  else
+    for (int i = 0;  i < taken.flush_count;  ++i)
+      if (taken.flush_key_is_method[i])  interp->methodCache.flushByMethod(taken.flush_keys[i]);
+      else                               interp->methodCache.flushSelective(taken.flush_keys[i]);
+
+  for (int i = 0;  i < taken.datum_count;  ++i)
+    interp->store_broadcast_datum(taken.datum_sizes[i], taken.datum_offsets[i], taken.data[i]);
+}
+
+
+// This core's method cache has just been flushed, so the flushes pending for it are moot,
+// and their keys may no longer be objects.
+void Coalesced_Broadcasts::drop_pending_flushes_here() {
+  Batch* b = &batches[Logical_Core::my_rank()];
+  lock(b);
+  b->flush_all = false;
+  b->flush_count = 0;
+  unlock(b);
+}
+
@@ -0,0 +1,98 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// Method cache flushes and interpreter data that every other core must see.
+// Instead of a message per core per flush, each core has a pending batch in shared memory:
+// a sender adds to the batch of every other core, and only sends a (payload-free)
+// applyPendingBroadcastsMessage to a core whose batch was empty. The receiver takes its whole
+// batch at once when handling that message.
+// A flush already pending is not added again, and past flush_threshold keys
+// the batch just becomes a full flush, which is cheaper by then anyway.
+//
+// A batch may be applied before a message that was sent after it was started; fine for flushes,
+// which are conservative, and for the broadcast data, which are last-writer-wins.
+// It must not be applied after a later message from a sender that added to it, though:
+// a sender that joins a batch another core scheduled owes the receiver an
+// applyPendingBroadcastsMessage of its own, sent before its next direct message to that core.
+// Keys are Oops that GC does not know about: a stale one can only cause an extra flush,
+// and a full GC flushes the caches anyway. -- see preGCAction_here
+
+class Coalesced_Broadcasts {
+public:
+  static bool use_coalesced_broadcasts; // threadsafe readonly config value
+
+  static const int flush_threshold = 16;
+  static const int max_data = 64;
+
+private:
+  struct Batch {
+    int lock;
+    bool is_scheduled;  // an applyPendingBroadcastsMessage is on its way
+    int scheduled_by;   // from this rank
+    bool flush_all;
+    int flush_count;
+    Oop flush_keys[flush_threshold];
+    bool flush_key_is_method[flush_threshold];
+    int datum_count;
+    int datum_sizes[max_data];
+    int datum_offsets[max_data];
+    u_int64 data[max_data];
+  } __attribute__((aligned(64)));
+  Batch batches[Max_Number_Of_Cores];
+
+  // Written and read by the sender only; a row per sender.
+  struct Owed_Applies {
+    bool to[Max_Number_Of_Cores];
+  } __attribute__((aligned(64)));
+  Owed_Applies owed_applies[Max_Number_Of_Cores];
+
+  int messages_sent;
+  int broadcasts_coalesced;
+
+  void lock(Batch* b) {
+    while (!OS_Interface::atomic_compare_and_swap(&b->lock, 0, 1))
+      ;
+  }
+  void unlock(Batch* b) {
+    OS_Interface::mem_fence();
+    b->lock = 0;
+  }
+
+  bool join(Batch* b, int sender, int rank);
+  void schedule(int rank);
+  void broadcast_flush(Oop key, bool is_method, bool all);
+
+public:
+  static Coalesced_Broadcasts* create();
+
+  // Bookkeeping without messages, so that tests can play several cores.
+  // The adds answer whether sender must now send rank an applyPendingBroadcastsMessage;
+  // add_datum_from answers false, too, when the batch is full and the datum was not added.
+  bool add_flush_from(int sender, int rank, Oop key, bool is_method, bool all);
+  bool add_datum_from(int sender, int rank, int size, int offset, u_int64 datum, bool* must_schedule);
+  bool take_owed_apply(int sender, int rank);
+
+  void flush_method_cache_everywhere()  { broadcast_flush(Oop::from_int(0), false, true); }
+  void flush_selective_everywhere(Oop s) { broadcast_flush(s, false, false); }
+  void flush_by_method_everywhere(Oop m) { broadcast_flush(m, true,  false); }
+  void broadcast_datum(int size, int offset, u_int64 datum);
+
+  void before_direct_send_to(int rank);
+  void apply_pending_here();
+  void drop_pending_flushes_here();
+
+  int get_messages_sent() { return messages_sent; }
+  int get_broadcasts_coalesced() { return broadcasts_coalesced; }
+};
+
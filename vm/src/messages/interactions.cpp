@@ -16,6 +16,8 @@
 
 Interactions The_Interactions;
 
+bool Interactions::run_remote_primitives_asynchronously = false;
+
 
 Object_p last_ctx_rcv; // xxx for debugging
 
@@ -96,7 +98,26 @@ static void run_primitive_print(fn_t f, const char* long_msg, const char* short_
             The_Squeak_Interpreter()->increment_global_sequence_number());
 }
 
-void Interactions::run_primitive(int dst, fn_t f) {
+// A remote primitive normally holds its core idle till dst answers.
+// Asynchronously, the core sends the primitive off with the process, and goes on to other work,
+// just as if the process had waited on a semaphore: the send already leaves the core with no
+// running process, while the process stays marked running so no other core takes it.
+// The main core runs the primitive, and instead of answering, puts the process to sleep
+// itself, hinting it to this core. -- see Squeak_Interpreter::finish_asynchronous_remote_primitive
+//
+// Only when the caller will just return to the interpreter: a caller that still has work to do
+// on the stack after the primitive (e.g. primitiveDoNamedPrimitiveWithArgs) must wait.
+
+bool Interactions::can_suspend_caller_of_remote_primitive() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  return run_remote_primitives_asynchronously
+    &&   interp->process_is_scheduled_and_executing()
+    &&  !interp->doing_primitiveClosureValueNoContextSwitch
+    &&  !interp->suppress_context_switching();
+}
+
+
+void Interactions::run_primitive(int dst, fn_t f, bool may_suspend_caller) {
   The_Squeak_Interpreter()->assert_stored_if_no_proc();
   Message_Statics::remote_prim_fn = f;
 
@@ -110,10 +131,21 @@ void Interactions::run_primitive(int dst, fn_t f) {
     return;
   }
   run_primitive_print(f, "caught", "<");
+  Timeline_Slice ts(Timeline::primitive, "remote primitive");
   
   The_Squeak_Interpreter()->assert_stored_if_no_proc();
 
-  SEND_THEN_WAIT_FOR_MESSAGE( runPrimitiveMessage_class(The_Squeak_Interpreter()->get_argumentCount(), f), dst,
+  if (may_suspend_caller  &&  can_suspend_caller_of_remote_primitive()) {
+    ++async_remote_prim_count;
+    runPrimitiveMessage_class(The_Squeak_Interpreter()->get_argumentCount(), f, true).send_to(dst);
+    The_Squeak_Interpreter()->assert_stored_if_no_proc();
+    remote_prim_cycles += OS_Interface::get_cycle_count() - start;
+    run_primitive_print(f, "went on from", "}");
+    Message_Statics::remote_prim_fn = 0;
+    return;
+  }
+
+  SEND_THEN_WAIT_FOR_MESSAGE( runPrimitiveMessage_class(The_Squeak_Interpreter()->get_argumentCount(), f, false), dst,
                               runPrimitiveResponse);
   
   The_Squeak_Interpreter()->assert_stored_if_no_proc();
@@ -186,9 +218,16 @@ void Interactions::do_all_roots_here(Oop_Closure* oc) {
 
 
 Oop Interactions::get_stats() {
+  Coalesced_Broadcasts* cb = The_Squeak_Interpreter()->coalesced_broadcasts; // shared, so not reset
+  int broadcast_messages_sent = cb == NULL  ?  0  :  cb->get_messages_sent();
+  int broadcasts_coalesced    = cb == NULL  ?  0  :  cb->get_broadcasts_coalesced();
+
   int s = The_Squeak_Interpreter()->makeArrayStart();
   PUSH_POSITIVE_32_BIT_INT_WITH_STRING_FOR_MAKE_ARRAY(remote_prim_count );  remote_prim_count  = 0;
+  PUSH_POSITIVE_32_BIT_INT_WITH_STRING_FOR_MAKE_ARRAY(async_remote_prim_count);  async_remote_prim_count = 0;
   PUSH_POSITIVE_64_BIT_INT_WITH_STRING_FOR_MAKE_ARRAY(remote_prim_cycles);  remote_prim_cycles = 0LL;
+  PUSH_POSITIVE_32_BIT_INT_WITH_STRING_FOR_MAKE_ARRAY(broadcast_messages_sent);
+  PUSH_POSITIVE_32_BIT_INT_WITH_STRING_FOR_MAKE_ARRAY(broadcasts_coalesced);
   return The_Squeak_Interpreter()->makeArray(s);
 }
 
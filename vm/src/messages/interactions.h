@@ -15,12 +15,15 @@
 class Interactions {
 public:
   const static bool verbose = false;
+  static bool run_remote_primitives_asynchronously; // threadsafe readonly config value
 
   int     remote_prim_count;
+  int     async_remote_prim_count;
   u_int64 remote_prim_cycles;
 
   Interactions() {
     remote_prim_count  = 0;
+    async_remote_prim_count = 0;
     remote_prim_cycles = 0LL;
   }
 
@@ -33,7 +36,10 @@ public:
   void recycleContextIfPossible(int dst, Oop, const int current_rank);
   Object* add_object_from_snapshot_allocating_chunk(int dst, Oop, Object*);
   void do_all_roots_here(Oop_Closure*);
-  void run_primitive(int dst, fn_t f);
+  void run_primitive(int dst, fn_t f, bool may_suspend_caller);
+ private:
+  bool can_suspend_caller_of_remote_primitive();
+ public:
   fn_t load_function_from_plugin(int dst, const char* fn, const char* plugin);
 
   void get_screen_info(int*, int*);
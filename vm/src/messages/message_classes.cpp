@@ -45,6 +45,19 @@ void addObjectFromSnapshotMessage_class::handle_me() {
 
 void addObjectFromSnapshotResponse_class::handle_me() {}
 
+void loadSnapshotPartitionMessage_class::handle_me() {
+  reader->add_objects_in_my_partition();
+  loadSnapshotPartitionResponse_class().send_to(sender);
+}
+
+void loadSnapshotPartitionResponse_class::handle_me() {}
+
+void writeSnapshotHeapsMessage_class::handle_me() {
+  writeSnapshotHeapsResponse_class(The_Memory_System()->write_my_snapshot_heaps(layout)).send_to(sender);
+}
+
+void writeSnapshotHeapsResponse_class::handle_me() {}
+
 void addedScheduledProcessMessage_class::handle_me()  {
   ++The_Squeak_Interpreter()->added_process_count;
 }
@@ -53,14 +66,7 @@ void addedScheduledProcessMessage_class::handle_me()  {
 
 
 void broadcastInterpreterDatumMessage_class::handle_me() {
-  void* p = (char*)The_Squeak_Interpreter() + datum_byte_offset;
-  assert_always(p < (void*)(The_Squeak_Interpreter() + 1));
-  switch (datum_size) {
-    default: fatal();
-    case sizeof(   char): *(   char*)p = (char)datum;  break;
-    case sizeof(    int): *(    int*)p = ( int)datum;  break;
-    case sizeof(u_int64): *(u_int64*)p =       datum;  break;
-  }
+  The_Squeak_Interpreter()->store_broadcast_datum(datum_size, datum_byte_offset, datum);
 }
 
 
@@ -148,6 +154,10 @@ void flushByMethodMessage_class::handle_me() {
   The_Squeak_Interpreter()->methodCache.flushByMethod(method);
 }
 
+void applyPendingBroadcastsMessage_class::handle_me() {
+  The_Squeak_Interpreter()->coalesced_broadcasts->apply_pending_here();
+}
+
 
 void setExtraWordSelectorMessage_class::handle_me() {
 # if Extra_Preheader_Word_Experiment
@@ -211,7 +221,7 @@ void requestSafepointOnOtherCoresMessage_class::handle_me() {
 
 
 void grantSafepointMessage_class::handle_me() {
-  The_Squeak_Interpreter()->safepoint_tracker->every_other_core_is_safe(sequence_number);
+  The_Squeak_Interpreter()->safepoint_tracker->every_other_core_is_safe(sequence_number, last_to_arrive);
 }
 
 
@@ -277,7 +287,10 @@ void runPrimitiveMessage_class::handle_me() {
     lprintf("sending runPrimitiveResponse 0x%x %d\n", fn,
             The_Squeak_Interpreter()->increment_global_sequence_number());
   }
-  runPrimitiveResponse_class().send_to(sender);
+  if (asynchronous)
+    The_Squeak_Interpreter()->finish_asynchronous_remote_primitive();
+  else
+    runPrimitiveResponse_class().send_to(sender);
 
   if (verbose) {
     lprintf("sent runPrimitiveResponse 0x%x %d\n", fn,
@@ -325,11 +338,15 @@ void scanCompactOrMakeFreeObjectsMessage_class::handle_me() {
 
 void startInterpretingMessage_class::handle_me() {}
 
-void transferControlMessage_class::handle_me() {
-  assert(!Logical_Core::my_rank() != sender);
-  subset.fill_in_interpreter();
+void microBenchmarkPingMessage_class::handle_me() {
+  microBenchmarkPingResponse_class().send_to(sender);
 }
 
+void microBenchmarkPingResponse_class::handle_me() {}
+
+void microBenchmarkContendMessage_class::handle_me() {
+  Micro_Benchmarks::contend_for_scheduler_mutex(count);
+}
 
 void updateEnoughInterpreterToTransferControlMessage_class::handle_me() {
   fatal("only subclasses should actually be used");
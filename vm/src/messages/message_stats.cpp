@@ -72,6 +72,24 @@ Oop Message_Stats::get_stats(int what_to_sample) {
 }
 
 
+// Answers {sends. receives}, per message type, summed over all threads without resetting them.
+Oop Message_Stats::get_totals() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  int s = interp->makeArrayStart();
+  for (int receiving = 0;  receiving < 2;  ++receiving) {
+    int r = interp->makeArrayStart();
+    for (int j = 0;  j < Message_Statics::end_of_messages;  ++j) {
+      u_int64 sum = 0;
+      for (size_t t = 0;  t < Memory_Semantics::max_num_threads_on_threads_or_1_on_processes;  ++t)
+        sum += receiving ? stats[t].receive_tallies[j] : stats[t].send_tallies[j];
+      PUSH_POSITIVE_64_BIT_INT_FOR_MAKE_ARRAY(sum);
+    }
+    PUSH_FOR_MAKE_ARRAY(interp->makeArray(r));
+  }
+  return interp->makeArray(s);
+}
+
+
 Oop Message_Stats::get_message_names() {
   int r = The_Squeak_Interpreter()->makeArrayStart();
   for (int i = 0;  i < Message_Statics::end_of_messages; ++i)
@@ -22,13 +22,14 @@ private:
     u_int64 receive_cycles [Message_Statics::end_of_messages];
     u_int64 buf_msg_check_cyc;
     int     buf_msg_check_count;
-  } statistics;
+  } __attribute__((aligned(64))) statistics; // one per thread
   
 public:
   
   static statistics stats[Memory_Semantics::max_num_threads_on_threads_or_1_on_processes];    // threadsafe
   
   static Oop get_stats(int);
+  static Oop get_totals();
   static Oop get_message_names();
 
   static void collect_send_msg_stats(int m) {
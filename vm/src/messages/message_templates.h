@@ -34,6 +34,10 @@ template(addedScheduledProcessMessage,abstractMessage, (), (), , , no_ack, dont_
 template(aboutToWriteReadMostlyMemoryMessage,abstractMessage, (void* p, int n), (), {addr = p; nbytes = n;}, void* addr; int nbytes;, no_ack, dont_delay_when_have_acquired_safepoint) \
 template(addObjectFromSnapshotMessage,abstractMessage, (Oop d, Object* s), (), {dst_oop = d; src_obj_wo_preheader = s;}, Oop dst_oop; Object* src_obj_wo_preheader; void do_all_roots(Oop_Closure*);, no_ack, dont_delay_when_have_acquired_safepoint) \
 template(addObjectFromSnapshotResponse,abstractMessage, (Object* d), (), {dst_obj = d;}, Object* dst_obj; void do_all_roots(Oop_Closure*);, no_ack, dont_delay_when_have_acquired_safepoint) \
+template(loadSnapshotPartitionMessage,abstractMessage, (Squeak_Image_Reader* r), (), {reader = r;}, Squeak_Image_Reader* reader;, no_ack, dont_delay_when_have_acquired_safepoint) \
+template(loadSnapshotPartitionResponse,abstractMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
+template(writeSnapshotHeapsMessage,abstractMessage, (Snapshot_Layout* l), (), {layout = l;}, Snapshot_Layout* layout;, no_ack, dont_delay_when_have_acquired_safepoint) \
+template(writeSnapshotHeapsResponse,abstractMessage, (bool o), (), {ok = o;}, bool ok;, no_ack, dont_delay_when_have_acquired_safepoint) \
 template(broadcastInterpreterDatumMessage,abstractMessage, (int s, int o, u_int64 d), (), {datum_size = s; datum_byte_offset = o; datum = d;}, int datum_size; int datum_byte_offset; u_int64 datum;, no_ack, dont_delay_when_have_acquired_safepoint) /*xxxxxx simple if no wait*/\
 template(doAllRootsHereMessage,abstractMessage, (Oop_Closure* oc, bool igp), (), { closure = oc; is_gc_permitted = igp; }, Oop_Closure* closure; bool is_gc_permitted; , no_ack, dont_delay_when_have_acquired_safepoint) \
 \
@@ -49,6 +53,7 @@ template(flushFreeContextsMessage,abstractMessage, (), (), , , post_ack_for_corr
 \
 template(flushInterpreterCachesMessage,abstractMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
 template(flushMethodCacheMessage,abstractMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
+template(applyPendingBroadcastsMessage,abstractMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
 template(flushSelectiveMessage,abstractMessage, (Oop s), (), { selector = s; }, Oop selector; void do_all_roots(Oop_Closure*); , no_ack, dont_delay_when_have_acquired_safepoint) \
 template(flushByMethodMessage,abstractMessage, (Oop x), (), { method = x; }, Oop method; void do_all_roots(Oop_Closure*); , no_ack, dont_delay_when_have_acquired_safepoint) \
 \
@@ -74,7 +79,7 @@ template(screenInfoResponse,abstractMessage, (int sz, int full), (), { screenSiz
 \
 template(requestSafepointOnOtherCoresMessage,abstractMessage, (const char* w), (), { why = w; }, const char* why; , no_ack, dont_delay_when_have_acquired_safepoint) \
 \
-template(grantSafepointMessage,abstractMessage, (int sn), (), { sequence_number = sn; }, int sequence_number;, no_ack, dont_delay_when_have_acquired_safepoint) \
+template(grantSafepointMessage,abstractMessage, (int sn, int lc), (), { sequence_number = sn; last_to_arrive = lc; }, int sequence_number; int last_to_arrive;, no_ack, dont_delay_when_have_acquired_safepoint) \
 \
 template(releaseOtherCoresFromSafepointMessage,abstractMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
 \
@@ -87,14 +92,16 @@ template(sampleOneCoreMessage,abstractMessage, (int w), (), {what_to_sample = w;
 template(sampleOneCoreResponse,abstractMessage, (Oop r), (), {result = r;}, Oop result;  void do_all_roots(Oop_Closure*);, post_ack_for_correctness, dont_delay_when_have_acquired_safepoint) \
 template(scanCompactOrMakeFreeObjectsMessage,abstractMessage, (bool c, Abstract_Mark_Sweep_Collector* g), (), {compacting = c; gc_or_null = g;}, bool compacting; Abstract_Mark_Sweep_Collector* gc_or_null; , post_ack_for_correctness, dont_delay_when_have_acquired_safepoint) \
 template(startInterpretingMessage,abstractMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
+template(microBenchmarkPingMessage,abstractMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
+template(microBenchmarkPingResponse,abstractMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
+template(microBenchmarkContendMessage,abstractMessage, (int c), (), {count = c;}, int count;, no_ack, dont_delay_when_have_acquired_safepoint) \
 template(verifyInterpreterAndHeapMessage,abstractMessage, (), (), , , post_ack_for_correctness, dont_delay_when_have_acquired_safepoint) \
 template(zapUnusedPortionOfHeapMessage,abstractMessage, (), (), , , post_ack_for_correctness, dont_delay_when_have_acquired_safepoint) \
 \
 /* have to do updateWholeInterpreter the hard way because of header order, sigh */ \
 template(distributeInitialInterpreterMessage,abstractMessage, (Squeak_Interpreter* i), (), { interp = i; }, Squeak_Interpreter* interp;, post_ack_for_correctness, dont_delay_when_have_acquired_safepoint) \
 template(updateEnoughInterpreterToTransferControlMessage,abstractMessage, (), (), , Interpreter_Subset_For_Control_Transfer subset; void send_to(int); void do_all_roots(Oop_Closure*);, no_ack, dont_delay_when_have_acquired_safepoint) \
-template(transferControlMessage,updateEnoughInterpreterToTransferControlMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
-template(runPrimitiveMessage,updateEnoughInterpreterToTransferControlMessage, (int c, fn_t f), (), { argCount = c; fn = f; }, int argCount; fn_t fn; , no_ack, delay_when_have_acquired_safepoint) \
+template(runPrimitiveMessage,updateEnoughInterpreterToTransferControlMessage, (int c, fn_t f, bool a), (), { argCount = c; fn = f; asynchronous = a; }, int argCount; fn_t fn; bool asynchronous; , no_ack, delay_when_have_acquired_safepoint) \
 template(runPrimitiveResponse, updateEnoughInterpreterToTransferControlMessage, (), (), , , no_ack, dont_delay_when_have_acquired_safepoint) \
 \
 
@@ -610,6 +610,9 @@ Object_p Object::process_list_for_priority_of_process() {
 // Save on given list for priority
 void Object::add_process_to_scheduler_list() {
   process_list_for_priority_of_process()->addLastLinkToList(as_oop());
+  The_Squeak_Interpreter()->note_ready_list_nonempty(priority_of_process());
+  if (!is_process_running())
+    The_Squeak_Interpreter()->hint_runnable_process(this);
 }
 
 
@@ -627,6 +630,8 @@ Oop Object::get_suspended_context_of_process_and_mark_running() {
 
   storePointer(Object_Indices::SuspendedContextIndex, The_Squeak_Interpreter()->roots.nilObj);
   store_host_core_of_process(Logical_Core::my_rank());
+  if (The_Squeak_Interpreter()->run_queues != NULL)
+    The_Squeak_Interpreter()->run_queues->note_running_on(this, Logical_Core::my_rank());
   return ctx;
 }
 
@@ -657,7 +662,7 @@ bool Object::is_process_running() {
 
 
 
-bool Object::is_process_allowed_to_run_on_this_core() {
+bool Object::is_process_allowed_to_run_on(int rank) {
   int acm = The_Process_Field_Locator.index_of_process_inst_var(Process_Field_Locator::coreMask);
   if (acm < 0) return true;
 
@@ -668,7 +673,7 @@ bool Object::is_process_allowed_to_run_on_this_core() {
     return true;
   }
   
-  bool r =  ((1LL << Logical_Core::my_rank()) & mask) ? true : false;
+  bool r =  ((1LL << rank) & mask) ? true : false;
   return r;
 }
 
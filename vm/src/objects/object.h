@@ -587,7 +587,8 @@ public:
   Object_p process_list_for_priority_of_process();
   Oop get_suspended_context_of_process_and_mark_running();
   bool is_process_running();
-  bool is_process_allowed_to_run_on_this_core();
+  bool is_process_allowed_to_run_on_this_core() { return is_process_allowed_to_run_on(Logical_Core::my_rank()); }
+  bool is_process_allowed_to_run_on(int rank);
   void store_host_core_of_process(int);
   void store_allowable_cores_of_process(u_int64 bitMask);
   void add_process_to_scheduler_list();
@@ -31,5 +31,8 @@ public:
    *                                                         (Stefan 2010-08-02)
    */
   static bool are_data_available(Logical_Core* const) { return false; };
+
+  // For NUMA: the queue itself is placed by the caller, this places any buffers it points to
+  void bind_buffers_to_rank(int) {}
 };
 
@@ -93,6 +93,80 @@ char* Abstract_OS_Interface::map_heap_memory(size_t total_size,
   return mem;
 }
 
+/**
+ * Maps the heap as private anonymous memory; only usable when all cores are
+ * threads of one process. No file is involved, so nothing needs to be unlinked.
+ * The mapping is aligned to the transparent huge page size, and the kernel is
+ * asked to back it with huge pages, which needs no boot-time reservation
+ * (unlike /dev/hugetlb). Whether it does so is up to
+ * /sys/kernel/mm/transparent_hugepage/enabled; see get_huge_page_backed_kb.
+ */
+char* Abstract_OS_Interface::map_anonymous_heap_memory(size_t bytes_to_map, bool want_transparent_huge_pages) {
+  assert_always(Using_Threads);
+  
+  const size_t alignment = transparent_huge_page_size;
+  const size_t bytes_with_slack = bytes_to_map + alignment;
+  
+  void* mmap_result = map_memory(bytes_with_slack, -1, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, NULL, 0,
+                                 "object heap (anonymous)");
+  if (mmap_result == MAP_FAILED) {
+    char buf[BUFSIZ];
+    snprintf(buf, sizeof(buf), "anonymous mmap failed. Requested %.2f MB for object heap. mmap",
+             (float)bytes_to_map / 1024.0 / 1024.0);
+    perror(buf);
+    fatal("mmap");
+  }
+  
+  // trim the slack so that the heap starts on a huge page boundary
+  char* raw = (char*)mmap_result;
+  char* mem = (char*)(((uintptr_t)raw + alignment - 1) & ~(uintptr_t)(alignment - 1));
+  if (mem > raw)
+    munmap(raw, mem - raw);
+  if (raw + bytes_with_slack > mem + bytes_to_map)
+    munmap(mem + bytes_to_map, (raw + bytes_with_slack) - (mem + bytes_to_map));
+  
+  if (want_transparent_huge_pages) {
+# ifdef MADV_HUGEPAGE
+    if (madvise(mem, bytes_to_map, MADV_HUGEPAGE) != 0)
+      perror("madvise(MADV_HUGEPAGE) failed, heap will use normal pages");
+# else
+    lprintf("transparent huge pages are not supported on this platform, heap will use normal pages\n");
+# endif
+  }
+  return mem;
+}
+
+
+/**
+ * Returns how many KB of [start, start + len) are currently backed by
+ * transparent huge pages, by summing AnonHugePages over the mappings in
+ * /proc/self/smaps that lie in the range. Returns -1 if that file is unavailable.
+ * Only pages that have been touched count.
+ */
+int64_t Abstract_OS_Interface::get_huge_page_backed_kb(void* start, size_t len) {
+  FILE* f = fopen("/proc/self/smaps", "r");
+  if (f == NULL) { return -1; }
+  
+  const uintptr_t range_start = (uintptr_t)start,  range_end = range_start + len;
+  int64_t result = 0;
+  bool in_range = false;
+  char line[BUFSIZ];
+  
+  while (fgets(line, sizeof(line), f) != NULL) {
+    unsigned long lo, hi;
+    char dash;
+    long kb;
+    if (sscanf(line, "%lx%c%lx ", &lo, &dash, &hi) == 3  &&  dash == '-')
+      in_range = range_start <= lo  &&  hi <= range_end;
+    else if (in_range  &&  sscanf(line, "AnonHugePages: %ld kB", &kb) == 1)
+      result += kb;
+  }
+  fclose(f);
+  
+  return result;
+}
+
+
 void* Abstract_OS_Interface::map_memory(size_t bytes_to_map,
                                         int    mmap_fd,
                                         int    flags,
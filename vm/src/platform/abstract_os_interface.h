@@ -48,6 +48,7 @@ public:
    * if they are equal set the new value and return true, false otherwise.
    */
   static inline bool atomic_compare_and_swap(int* /* ptr */, int /* old_value */, int /* new_value */) { fatal(); return false; }
+  static inline bool atomic_compare_and_swap(oop_int_t* /* ptr */, oop_int_t /* old_value */, oop_int_t /* new_value */) { fatal(); return false; }
   
   /**
    * Atomically compare the memory location with the old value, and 
@@ -90,12 +91,26 @@ public:
   
   static inline void yield_or_spin_a_bit() { fatal(); }
   
+  /* NUMA placement: platforms without a notion of memory nodes treat the
+     whole machine as a single node and leave placement to the OS. */
+  static void discover_numa_topology()                                    {}
+  static inline int  numa_node_count()                                    { return 1; }
+  static inline int  numa_node_of_rank(int /* rank */)                    { return 0; }
+  static bool bind_memory_to_rank(void* /* start */, size_t /* len */, int /* rank */) { return false; }
+
+  /* Idle parking: sleep while *addr == expected, until futex_wake or the timeout.
+     Without futexes, just sleep out the timeout. */
+  static void futex_wait(int* /* addr */, int /* expected */, int timeout_usecs) { usleep(timeout_usecs); }
+  static void futex_wake(int* /* addr */)                                       {}
+  
   static bool AmIBeingDebugged() { fatal(); return false; }
   
 protected:
   static char  mmap_filename[BUFSIZ];
 
 public:  
+  static const size_t transparent_huge_page_size = 2 * Mega; // x86-64 PMD size
+  
   static void check_requested_heap_size(size_t heap_size);
   static int64_t get_available_main_mem_in_kb();
   
@@ -105,6 +120,9 @@ public:
                                int main_pid, int flags);  
   static void unlink_heap_file();
   
+  static char* map_anonymous_heap_memory(size_t bytes_to_map, bool want_transparent_huge_pages);
+  static int64_t get_huge_page_backed_kb(void* start, size_t len);
+  
   static void* map_memory(size_t bytes_to_map, int    mmap_fd,
                           int    flags, void*  start_address,
                           off_t  offset_in_backing_file,
@@ -85,6 +85,9 @@ public:
   static inline bool atomic_compare_and_swap(int* ptr, int old_value, int new_value) {
     return (0 == atomic_compare_and_exchange_bool_acq(ptr, new_value, old_value)); // Not sure whether that is stable, this API is unintuitive for me, got it wrong twice!! make sure the test cases are rerun on new lib versions
   }
+  static inline bool atomic_compare_and_swap(oop_int_t* ptr, oop_int_t old_value, oop_int_t new_value) {
+    return (0 == atomic_compare_and_exchange_bool_acq(ptr, new_value, old_value));
+  }
   
   /**
    * Atomically compare the memory location with the old value, and 
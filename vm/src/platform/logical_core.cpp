@@ -12,6 +12,7 @@
  ******************************************************************************/
 
 
+# include <new>
 # include "headers.h"
 
 Logical_Core* logical_cores;
@@ -24,8 +25,38 @@ int Logical_Core::remaining  = -1;
 
 
 void Logical_Core::initialize_all_cores() {
-  logical_cores = new Logical_Core[num_cores];
+  // The message rings inside want their own cache lines, which plain new does not promise.
+  logical_cores = (Logical_Core*)OS_Interface::rvm_memalign(64, num_cores * sizeof(Logical_Core));
+  if (logical_cores == NULL)  fatal("could not allocate the logical cores");
 
-  for (size_t i = 0;  i < size_t(num_cores);  ++i)
+  for (size_t i = 0;  i < size_t(num_cores);  ++i) {
+    new (&logical_cores[i]) Logical_Core();
     logical_cores[i].initialize(i);
+    // Senders write into the receiver's queue, but the receiver polls it all the time.
+    // The queue object itself is smaller than a page; only its buffers can be placed.
+    if (Memory_System::use_numa)
+      logical_cores[i].message_queue.bind_buffers_to_rank(i);
+  }
+}
+
+
+// After a change that every idle core must notice, such as forceInterruptCheck
+void Logical_Core::unpark_all_others() {
+  FOR_ALL_OTHER_RANKS(r)
+    logical_cores[r].unpark();
+}
+
+
+// Wakes a parked core, if any, other than this one and rank, starting after rank,
+// so that it can take work that rank is too busy for. Answers whether it found one.
+bool Logical_Core::unpark_one_other_than(int rank) {
+  if (!Using_Threads)  return false;
+  for (int i = 1;  i < group_size;  ++i) {
+    int r = (rank + i) % group_size;
+    if (r != my_rank()  &&  logical_cores[r].is_parked()) {
+      logical_cores[r].unpark();
+      return true;
+    }
+  }
+  return false;
 }
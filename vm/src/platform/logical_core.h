@@ -30,11 +30,36 @@ public:
   
   Message_Queue  message_queue;
   CPU_Coordinate coordinate;
-  
+
+private:
+  // Idle parking, with threads only: an idle core sleeps on this word instead of spinning,
+  // and whoever sends it a message or gives it a process to run wakes it.
+  // On its own cache line, since every sender to this core reads it.
+  char _pad_before_parked[64];
+  int  parked;  // 1 from announce_parking till woken
+  char _pad_after_parked[64 - sizeof(int)];
+
+public:
   void initialize(int rank) {
     _rank = rank;
     _rank_mask = 1LL << u_int64(rank);
     coordinate.initialize(rank);
+    parked = 0;
+  }
+
+  // Owner: announce, check once more for work, then park.
+  // The fences pair up with unpark's, so either the owner sees the work or the waker sees parked.
+  void announce_parking() { parked = 1;  OS_Interface::mem_fence(); }
+  void park(int timeout_usecs) { OS_Interface::futex_wait(&parked, 1, timeout_usecs);  parked = 0; }
+  void stop_parking() { parked = 0; }
+  bool is_parked() const { return parked; }
+
+  // Anyone, after giving this core work
+  inline void unpark() {
+    if (!Using_Threads)  return;
+    OS_Interface::mem_fence();
+    if (parked  &&  OS_Interface::atomic_compare_and_swap(&parked, 1, 0))
+      OS_Interface::futex_wake(&parked);
   }
   
   inline int      rank()      const { assert(this != NULL); return _rank; }
@@ -81,6 +106,8 @@ public:
   
   
   static void initialize_all_cores();
+  static void unpark_all_others();
+  static bool unpark_one_other_than(int rank);
   
   static inline Logical_Core* main_core() { return &logical_cores[main_rank]; }
   static inline bool running_on_main() {
@@ -46,6 +46,114 @@ void POSIX_OS_Interface::pin_thread_to_core(int32_t rank) {
 }
 
 
+# if On_Intel_Linux
+
+# include <sys/syscall.h>
+# include <linux/futex.h>
+
+# ifndef MPOL_BIND
+  # define MPOL_BIND    2
+# endif
+# ifndef MPOL_MF_MOVE
+  # define MPOL_MF_MOVE (1 << 1)
+# endif
+
+int POSIX_OS_Interface::numa_nodes = 1;
+int POSIX_OS_Interface::numa_node_for_cpu[Max_Number_Of_Cores] = { 0 };
+
+
+/**
+ * Reads /sys/devices/system/node/node<N>/cpulist, which looks like "0-7,16-23",
+ * and records N as the node of every listed CPU.
+ * Returns the number of CPUs found, or -1 if the node does not exist.
+ */
+int POSIX_OS_Interface::parse_cpulist_of_numa_node(int node) {
+  char path[BUFSIZ];
+  snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+  FILE* f = fopen(path, "r");
+  if (f == NULL)
+    return -1;
+  
+  char list[BUFSIZ];
+  int n = 0;
+  if (fgets(list, sizeof(list), f) != NULL) {
+    for (char* p = list;  *p != '\0'  &&  *p != '\n';  ) {
+      char* after;
+      int first = strtol(p, &after, 10);
+      if (after == p)  break;
+      int last = first;
+      if (*after == '-')
+        last = strtol(after + 1, &after, 10);
+      for (int cpu = first;  cpu <= last;  ++cpu, ++n)
+        if (cpu < Max_Number_Of_Cores)
+          numa_node_for_cpu[cpu] = node;
+      p = *after == ','  ?  after + 1  :  after;
+    }
+  }
+  fclose(f);
+  return n;
+}
+
+
+// Ranks are pinned to the CPU with the same number (see pin_thread_to_core),
+// so the node of a rank is the node of that CPU.
+void POSIX_OS_Interface::discover_numa_topology() {
+  numa_nodes = 0;
+  for (int node = 0;  parse_cpulist_of_numa_node(node) >= 0;  ++node)
+    numa_nodes = node + 1;
+  
+  if (numa_nodes == 0) {
+    numa_nodes = 1;
+    lprintf("NUMA: no topology found in /sys/devices/system/node, assuming a single node\n");
+    return;
+  }
+  lprintf("NUMA: %d node(s); rank 0 on node %d, rank %d on node %d\n",
+          numa_nodes, numa_node_of_rank(0),
+          Logical_Core::num_cores - 1, numa_node_of_rank(Logical_Core::num_cores - 1));
+}
+
+
+/**
+ * Binds the whole pages within [start, start + len) to the node of rank, moving
+ * any that have already been touched. Pages only partially covered by the range
+ * are left alone, since they may belong to a neighbour.
+ * Uses the raw system call to avoid depending on libnuma.
+ */
+bool POSIX_OS_Interface::bind_memory_to_rank(void* start, size_t len, int rank) {
+  const uintptr_t page = getpagesize();
+  uintptr_t first = ((uintptr_t)start + page - 1) & ~(page - 1);
+  uintptr_t past  = ((uintptr_t)start + len) & ~(page - 1);
+  if (past <= first)
+    return false;
+  
+  unsigned long node_mask = 1UL << numa_node_of_rank(rank);
+  if (syscall(SYS_mbind, (void*)first, past - first, MPOL_BIND, &node_mask, sizeof(node_mask) * 8, MPOL_MF_MOVE) != 0) {
+    static bool reported = false;
+    if (!reported) {
+      reported = true;
+      perror("NUMA: mbind failed, falling back to first-touch placement");
+    }
+    return false;
+  }
+  return true;
+}
+
+
+// Private futexes: only threads park this way, see Logical_Core::park
+void POSIX_OS_Interface::futex_wait(int* addr, int expected, int timeout_usecs) {
+  struct timespec ts;
+  ts.tv_sec  =  timeout_usecs / 1000000;
+  ts.tv_nsec = (timeout_usecs % 1000000) * 1000;
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, &ts, NULL, 0); // EAGAIN, EINTR or ETIMEDOUT are all fine
+}
+
+void POSIX_OS_Interface::futex_wake(int* addr) {
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+# endif // On_Intel_Linux
+
+
 int32_t POSIX_OS_Interface::last_rank = 0;
 
 void* POSIX_OS_Interface::pthread_thread_main(void* param) {
@@ -87,6 +195,9 @@ void POSIX_OS_Interface::start_threads(void (*helper_core_main)(), char** /* arg
   pthread_setspecific(rank_key, (const void*)0);
 # endif
   
+  if (Memory_System::use_numa)
+    OS_Interface::discover_numa_topology();
+  
   Logical_Core::initialize_all_cores();
   
   Memory_Semantics::initialize_logical_cores();
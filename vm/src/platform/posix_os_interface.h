@@ -137,6 +137,9 @@ public:
   static inline bool atomic_compare_and_swap(int* ptr, int old_value, int new_value) {
     return __sync_bool_compare_and_swap(ptr, old_value, new_value);
   }
+  static inline bool atomic_compare_and_swap(oop_int_t* ptr, oop_int_t old_value, oop_int_t new_value) {
+    return __sync_bool_compare_and_swap(ptr, old_value, new_value);
+  }
 
   /**
    * Atomically compare the memory location with the old value, and 
@@ -214,6 +217,23 @@ public:
 
   static void pin_thread_to_core(int32_t rank);
 
+# if On_Intel_Linux
+  static void discover_numa_topology();
+  static inline int numa_node_count() { return numa_nodes; }
+  static inline int numa_node_of_rank(int rank) {
+    return (0 <= rank  &&  rank < Max_Number_Of_Cores)  ?  numa_node_for_cpu[rank]  :  0;
+  }
+  static bool bind_memory_to_rank(void* start, size_t len, int rank);
+
+  static void futex_wait(int* addr, int expected, int timeout_usecs);
+  static void futex_wake(int* addr);
+
+private:
+  static int numa_nodes;                                // threadsafe, read only after discover_numa_topology
+  static int numa_node_for_cpu[Max_Number_Of_Cores];    // threadsafe, read only after discover_numa_topology
+  static int parse_cpulist_of_numa_node(int node);
+# endif
+
 private:
   static void* pthread_thread_main(void* param);
   static int32_t       last_rank;  // needs to be accessed atomically (__sync_fetch_and_add)
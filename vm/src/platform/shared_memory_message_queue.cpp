@@ -40,34 +40,36 @@ void Shared_Memory_Message_Queue::release_oldest_buffer(void* buffer_to_be_relea
 }
 
 
+bool Shared_Memory_Message_Queue::are_data_available(Logical_Core* const receiver) {
+# if Use_Message_Ring
+  // only the receiver may ask its ring
+  assert(receiver == Logical_Core::my_core());
+  return receiver->message_queue.buffered_channel.hasData();
+# else
+  // TODO STEFAN: was never implemented for buffered channels, 
+  //    there is no api on tilera for that, on x86 I should fix my queue,
+  //    or measure whether the debug version would slow it down,
+  //    if it would use hasData() to implement this here.
+  return false; //buffered_channel.hasData();
+# endif
+}
+
+
+void Shared_Memory_Message_Queue::bind_buffers_to_rank(int rank) {
+# if Use_Message_Ring
+  OS_Interface::bind_memory_to_rank(buffered_channel.storage(), buffered_channel.storage_size(), rank);
+# endif
+}
+
+
 
 # include <signal.h>
 
 
 void Shared_Memory_Message_Queue::send_message(abstractMessage_class* msg) {
-#warning STEFAN: needs to be refactored. Shared_Memory_Message_Queue_Per_Sender and Shared_Memory_Message_Queue have identical implementations.
-  
+  // Only the way of buffering differs between the shared-memory queues.
   Message_Stats::collect_send_msg_stats(msg->header);
-  bool verbose = false;
-  switch(msg->header) {
-      // case Message_Statics::requestSafepointMessage:
-      // case Message_Statics::noMessage:
-    case Message_Statics::addObjectFromSnapshotMessage:
-    case Message_Statics::addObjectFromSnapshotResponse:
-    case Message_Statics::broadcastInterpreterDatumMessage:
-      verbose = false;
-  }
-  
-  if (verbose) lprintf( "send_message about to send header %d, three words: 0x%x, 0x%x, 0x%x\n",
-                       msg->header, ((int*)msg)[0], ((int*)msg)[1], ((int*)msg)[2]);
-  
-  
-  if (verbose) lprintf( "send_message about to send to %d, size: %d bytes, three words: 0x%x, 0x%x, 0x%x\n",
-                       cpu_core_my_rank(), msg->size_for_transmission_and_copying(), ((int*)msg)[0], ((int*)msg)[1], ((int*)msg)[2]);
-  
   buffered_send_buffer(msg, msg->size_for_transmission_and_copying());
-  
-  if (verbose) lprintf( "send_message sent\n");
 }
 
 # endif // !Use_PerSender_Message_Queue
@@ -16,7 +16,9 @@
 
 class Shared_Memory_Message_Queue : public Abstract_Message_Queue {
 protected:
-  #if Use_BufferedChannelDebug
+  #if Use_Message_Ring
+    MessageRing          buffered_channel;
+  #elif Use_BufferedChannelDebug
     BufferedChannelDebug buffered_channel;
   #else
     BufferedChannel      buffered_channel;
@@ -24,7 +26,11 @@ protected:
 
 public:
   Shared_Memory_Message_Queue() :
-    #if Use_BufferedChannelDebug
+    #if Use_Message_Ring
+      buffered_channel(Message_Ring_Bytes) {
+      assert_always(Message_Statics::max_message_size() <= buffered_channel.max_message_size());
+    }
+    #elif Use_BufferedChannelDebug
       buffered_channel(BufferedChannelDebug()) {}
     #else
       buffered_channel(BufferedChannel(Number_Of_Channel_Buffers, Message_Statics::max_message_size())) {}
@@ -38,13 +44,9 @@ public:
   void release_oldest_buffer(void*);
   
   
-  static bool are_data_available(Logical_Core* const /* receiver */) {
-    // TODO STEFAN: was never implemented for buffered channels, 
-    //    there is no api on tilera for that, on x86 I should fix my queue,
-    //    or measure whether the debug version would slow it down,
-    //    if it would use hasData() to implement this here.
-    return false; //buffered_channel.hasData();
-  }
+  static bool are_data_available(Logical_Core* const receiver);
+
+  void bind_buffers_to_rank(int);
   
 };
 
@@ -48,29 +48,9 @@ void Shared_Memory_Message_Queue_Per_Sender::release_oldest_buffer(void* buffer_
 
 
 void Shared_Memory_Message_Queue_Per_Sender::send_message(abstractMessage_class* msg) {
-#warning STEFAN: needs to be refactored. Shared_Memory_Message_Queue_Per_Sender and Shared_Memory_Message_Queue have identical implementations.
-  
+  // Only the way of buffering differs between the shared-memory queues.
   Message_Stats::collect_send_msg_stats(msg->header);
-  bool verbose = false;
-  switch(msg->header) {
-      // case Message_Statics::requestSafepointMessage:
-      // case Message_Statics::noMessage:
-    case Message_Statics::addObjectFromSnapshotMessage:
-    case Message_Statics::addObjectFromSnapshotResponse:
-    case Message_Statics::broadcastInterpreterDatumMessage:
-      verbose = false;
-  }
-  
-  if (verbose) lprintf( "send_message about to send header %d, three words: 0x%x, 0x%x, 0x%x\n",
-                       msg->header, ((int*)msg)[0], ((int*)msg)[1], ((int*)msg)[2]);
-  
-  
-  if (verbose) lprintf( "send_message about to send to %d, size: %d bytes, three words: 0x%x, 0x%x, 0x%x\n",
-                       cpu_core_my_rank(), msg->size_for_transmission_and_copying(), ((int*)msg)[0], ((int*)msg)[1], ((int*)msg)[2]);
-  
   buffered_send_buffer(msg, msg->size_for_transmission_and_copying());
-  
-  if (verbose) lprintf( "send_message sent\n");
 }
 
 # endif // !Use_PerSender_Message_Queue
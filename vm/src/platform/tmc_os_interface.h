@@ -93,6 +93,9 @@ public:
   static inline bool atomic_compare_and_swap(int* ptr, int old_value, int new_value) {
     return atomic_bool_compare_and_exchange(ptr, old_value, new_value);
   }
+  static inline bool atomic_compare_and_swap(oop_int_t* ptr, oop_int_t old_value, oop_int_t new_value) {
+    return atomic_bool_compare_and_exchange(ptr, old_value, new_value);
+  }
   
   /**
    * Atomically compare the memory location with the old value, and 
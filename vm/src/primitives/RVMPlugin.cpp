@@ -386,19 +386,35 @@ void* primitiveMoveAllToReadMostlyHeaps() {
 }
 
 
+static bool stream_trace_to_file_named(Abstract_Tracer* t, Oop name) {
+  char file_name[1024];
+  int n = min(name.as_object()->stSize(), (int)sizeof(file_name) - 1);
+  bcopy(name.as_object()->first_byte_address(), file_name, n);
+  file_name[n] = '\0';
+  return t->start_streaming(file_name);
+}
+
 void* primitiveTraceCores() {
   switch (The_Squeak_Interpreter()->get_argumentCount()) {
-    case 1: { // start tracing, size arg
-      int n = The_Squeak_Interpreter()->stackIntegerValue(0);
+    case 1: case 2: { // start tracing, size arg (in all), optionally streaming to the file named by a second arg
+      const int argc = The_Squeak_Interpreter()->get_argumentCount();
+      int n = The_Squeak_Interpreter()->stackIntegerValue(argc - 1);
       if (!The_Squeak_Interpreter()->successFlag  ||  n < 0) break;
+      if (argc == 2  &&  !The_Squeak_Interpreter()->stackTop().isBytes()) break;
       Core_Tracer* t = The_Squeak_Interpreter()->core_tracer();
       if (t != NULL) {
         The_Squeak_Interpreter()->set_core_tracer(NULL);
         delete t;
       }
-      if (n > 0)
-        The_Squeak_Interpreter()->set_core_tracer(new Core_Tracer(n));
-      The_Squeak_Interpreter()->pop(1);
+      if (n > 0) {
+        t = new Core_Tracer(n);
+        if (argc == 2  &&  !stream_trace_to_file_named(t, The_Squeak_Interpreter()->stackTop())) {
+          delete t;
+          break;
+        }
+        The_Squeak_Interpreter()->set_core_tracer(t);
+      }
+      The_Squeak_Interpreter()->pop(argc);
       return 0;
     }
 
@@ -468,17 +484,25 @@ void* primitiveAllObjectsInHeap() {
 
 void* primitiveTraceMutatedReplicatedObjects() {
   switch (The_Squeak_Interpreter()->get_argumentCount()) {
-    case 1: { // start tracing, size arg
-      int n = The_Squeak_Interpreter()->stackIntegerValue(0);
+    case 1: case 2: { // start tracing, size arg (in all), optionally streaming to the file named by a second arg
+      const int argc = The_Squeak_Interpreter()->get_argumentCount();
+      int n = The_Squeak_Interpreter()->stackIntegerValue(argc - 1);
       if (!The_Squeak_Interpreter()->successFlag  ||  n < 0) break;
+      if (argc == 2  &&  !The_Squeak_Interpreter()->stackTop().isBytes()) break;
       Oop_Tracer* t = The_Squeak_Interpreter()->mutated_read_mostly_object_tracer();
       if (t != NULL) {
         The_Squeak_Interpreter()->set_mutated_read_mostly_object_tracer(NULL);
         delete t;
       }
-      if (n > 0)
-        The_Squeak_Interpreter()->set_mutated_read_mostly_object_tracer(new Oop_Tracer(n));
-      The_Squeak_Interpreter()->pop(1);
+      if (n > 0) {
+        t = new Oop_Tracer(n);
+        if (argc == 2  &&  !stream_trace_to_file_named(t, The_Squeak_Interpreter()->stackTop())) {
+          delete t;
+          break;
+        }
+        The_Squeak_Interpreter()->set_mutated_read_mostly_object_tracer(t);
+      }
+      The_Squeak_Interpreter()->pop(argc);
       return 0;
     }
 
@@ -592,12 +616,53 @@ static int primitivePrintStats() {
   The_Squeak_Interpreter()->pop(The_Squeak_Interpreter()->get_argumentCount());
   
   Performance_Counters::print();
+  Hardware_Counters::print();
   
   return 0;
 }
 
 static int primitiveResetPerfCounters() {
   Performance_Counters::reset();
+  Hardware_Counters::reset();
+  return 0;
+}
+
+// Answers {name. total over all cores. ...} for each of the Performance_Counters, then
+// 'messages' and {sends. receives} per message type, in the order of the messageNames of primitiveSampleRVM.
+// With true or false, first turns counting on or off.
+static int primitivePerformanceCounters() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() > 1) { interp->primitiveFail(); return 0; }
+  if (interp->get_argumentCount() == 1) {
+    Oop arg = interp->stackTop();
+    if (arg != interp->roots.trueObj  &&  arg != interp->roots.falseObj) { interp->primitiveFail(); return 0; }
+    Performance_Counters::enabled = arg == interp->roots.trueObj;
+  }
+  int s = interp->makeArrayStart();
+  PUSH_STRING_FOR_MAKE_ARRAY("enabled");
+  PUSH_BOOL_FOR_MAKE_ARRAY(Performance_Counters::enabled);
+# define PUSH_TOTAL(name, type, initial_value) \
+  PUSH_STRING_FOR_MAKE_ARRAY(#name); \
+  PUSH_POSITIVE_64_BIT_INT_FOR_MAKE_ARRAY(Performance_Counters::total_##name());
+  FOR_ALL_PERFORMANCE_COUNTERS_DO(PUSH_TOTAL)
+  FOR_ALL_PERFORMANCE_ACCUMULATORS_DO(PUSH_TOTAL)
+# undef PUSH_TOTAL
+  PUSH_STRING_FOR_MAKE_ARRAY("messages");
+  PUSH_FOR_MAKE_ARRAY(Message_Stats::get_totals());
+  interp->popThenPush(interp->get_argumentCount() + 1, interp->makeArray(s));
+  return 0;
+}
+
+// Answers, per core, nil or per phase {instructions. cacheMisses. branchMisses. llcLoads}, see Hardware_Counters.
+// With true, also resets them.
+static int primitiveHardwareCounters() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() > 1  ||  !Hardware_Counters::use_hardware_counters) { interp->primitiveFail(); return 0; }
+  bool reset = interp->get_argumentCount() == 1  &&  interp->stackTop() == interp->roots.trueObj;
+  Oop r = Hardware_Counters::get_stats();
+  if (reset)
+    Hardware_Counters::reset();
+  interp->popThenPush(interp->get_argumentCount() + 1, r);
   return 0;
 }
   
@@ -751,6 +816,125 @@ static int primitiveRunningProcessByCore() {
   return 0;
 }
 
+// aProcess, aCoreRankOrMinusOne: where a process would rather be resumed;
+// unlike coreMask, other cores still run it if it waits too long. See Run_Queues.
+static int primitiveSetProcessSoftAffinity() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() != 2  ||  interp->run_queues == NULL) { interp->primitiveFail(); return 0; }
+  Oop proc = interp->stackValue(1);
+  Oop rank = interp->stackTop();
+  if (   !proc.is_mem()  ||  !proc.isKindOf(interp->splObj(Special_Indices::ClassProcess))
+      || !rank.is_int()  ||  rank.integerValue() < -1  ||  rank.integerValue() >= Logical_Core::group_size) {
+    interp->primitiveFail();
+    return 0;
+  }
+  {
+    Scheduler_Mutex sm("primitiveSetProcessSoftAffinity");
+    interp->run_queues->set_preferred_rank(proc.as_object(), rank.integerValue());
+  }
+  interp->pop(2);
+  return 0;
+}
+
+// Answers {migrations. resumes on the last core. handoffs to parked cores.
+// total and max nanoseconds from runnable to running for migrations}, summed over all cores
+static int primitiveProcessMigrations() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() != 0  ||  interp->run_queues == NULL) { interp->primitiveFail(); return 0; }
+  int s = interp->makeArrayStart();
+  PUSH_FOR_MAKE_ARRAY(Oop::from_int(interp->run_queues->total_migrations()));
+  PUSH_FOR_MAKE_ARRAY(Oop::from_int(interp->run_queues->total_affine_resumes()));
+  PUSH_FOR_MAKE_ARRAY(Oop::from_int(interp->run_queues->total_handoffs()));
+  PUSH_FOR_MAKE_ARRAY(Object::positive64BitIntegerFor(interp->run_queues->total_migration_nsecs()));
+  PUSH_FOR_MAKE_ARRAY(Object::positive64BitIntegerFor(interp->run_queues->max_migration_nsecs_of_all()));
+  interp->popThenPush(1, interp->makeArray(s));
+  return 0;
+}
+
+// Answers, per safepoint reason, {why. count. totalArrivalNanoseconds. maxArrivalNanoseconds. totalHoldNanoseconds. maxHoldNanoseconds.
+// arrivalHistogram. holdHistogram. lastToArriveByRank}, see Safepoint_Stats.
+// With true, also resets them.
+static int primitiveSafepointStatistics() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() > 1  ||  interp->safepoint_stats == NULL) { interp->primitiveFail(); return 0; }
+  bool reset = interp->get_argumentCount() == 1  &&  interp->stackTop() == interp->roots.trueObj;
+  Oop r = interp->safepoint_stats->get_stats();
+  if (reset) {
+    // the holder of a safepoint is the only writer; its own hold is then the first one recorded
+    Safepoint_for_moving_objects sf("primitiveSafepointStatistics reset");
+    interp->safepoint_stats->reset();
+  }
+  interp->popThenPush(interp->get_argumentCount() + 1, r);
+  return 0;
+}
+
+// With a period in microseconds, starts the sampling profiler on every core; with 0, stops it.
+static int primitiveStartSamplingProfiler() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() != 1  ||  !Sampling_Profiler::is_supported()) { interp->primitiveFail(); return 0; }
+  oop_int_t usecs = interp->stackIntegerValue(0);
+  if (!interp->successFlag  ||  usecs < 0) { interp->primitiveFail(); return 0; }
+  Sampling_Profiler::set_period_everywhere(usecs);
+  interp->pop(1);
+  return 0;
+}
+
+// Answers the sampled stacks of all cores as a String of folded lines, "core3;Foo>>bar;Foo>>baz 17".
+// With true, also resets them.
+static int primitiveSampledStacks() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() > 1  ||  !Sampling_Profiler::is_supported()) { interp->primitiveFail(); return 0; }
+  bool reset = interp->get_argumentCount() == 1  &&  interp->stackTop() == interp->roots.trueObj;
+  Oop r = Sampling_Profiler::sampled_stacks(reset);
+  interp->popThenPush(interp->get_argumentCount() + 1, r);
+  return 0;
+}
+
+// With a number of bytes between samples, or 0 to stop, and whether to count the live objects
+// per class after each full GC, (re)starts the allocation profiler on every core.
+static int primitiveStartAllocationProfiler() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() != 2  ||  !Allocation_Profiler::is_supported()) { interp->primitiveFail(); return 0; }
+  oop_int_t bytes = interp->stackIntegerValue(1);
+  Oop census = interp->stackTop();
+  if (!interp->successFlag  ||  bytes < 0  ||  (census != interp->roots.trueObj  &&  census != interp->roots.falseObj)) {
+    interp->primitiveFail();
+    return 0;
+  }
+  Allocation_Profiler::start(bytes, census == interp->roots.trueObj);
+  interp->pop(2);
+  return 0;
+}
+
+// Answers a String with the allocation sites of all cores, "Array <- Foo>>bar @ 23", by estimated bytes,
+// and the live objects per class as of the last full GC. With true, also resets the sites.
+static int primitiveAllocationProfile() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() > 1  ||  !Allocation_Profiler::is_supported()) { interp->primitiveFail(); return 0; }
+  bool reset = interp->get_argumentCount() == 1  &&  interp->stackTop() == interp->roots.trueObj;
+  Oop r = Allocation_Profiler::profile(reset);
+  interp->popThenPush(interp->get_argumentCount() + 1, r);
+  return 0;
+}
+
+// With -bench, marks the start of an iteration; the argument is true for a warmup one. See Image_Benchmark.
+static int primitiveBenchmarkBegin() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  Oop arg = interp->stackTop();
+  if (interp->get_argumentCount() != 1  ||  !Image_Benchmark::is_requested()
+  ||  (arg != interp->roots.trueObj  &&  arg != interp->roots.falseObj)) { interp->primitiveFail(); return 0; }
+  Image_Benchmark::begin_iteration(arg == interp->roots.trueObj);
+  interp->pop(1);
+  return 0;
+}
+
+// With -bench, marks the end of an iteration; after the last one, writes the report and quits.
+static int primitiveBenchmarkEnd() {
+  if (!Image_Benchmark::is_requested()) { The_Squeak_Interpreter()->primitiveFail(); return 0; }
+  Image_Benchmark::end_iteration();
+  return 0;
+}
+
 static int primitiveWriteSnapshot() {
   // for debugging
   if (The_Squeak_Interpreter()->get_argumentCount() == 0)
@@ -764,6 +948,28 @@ static int primitiveWriteSnapshot() {
   return 0;
 }
 
+// With a semaphore index, write the image from a forked child while we keep running
+// (needs -background_snapshots); the semaphore is signalled when it is done.
+// Without, answer whether the last one worked.
+static int primitiveBackgroundSnapshot() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  if (interp->get_argumentCount() == 0) {
+    interp->popThenPush(1, The_Memory_System()->last_background_snapshot_succeeded() ? interp->roots.trueObj : interp->roots.falseObj);
+    return 0;
+  }
+  Oop sema = interp->stackTop();
+  if (interp->get_argumentCount() != 1  ||  !sema.is_int()  ||  !The_Memory_System()->can_start_background_snapshot()) {
+    interp->primitiveFail();
+    return 0;
+  }
+  interp->pop(1);
+  if (!interp->background_snapshot(sema.integerValue())) {
+    interp->push(sema);
+    interp->primitiveFail();
+  }
+  return 0;
+}
+
 
 static int primitiveMicrosecondClock() {
   // return a microsecond clock
@@ -864,6 +1070,8 @@ void* RVMPlugin_exports[][3] = {
   {(void*) "RVMPlugin", (void*)"primitivePrint", (void*)primitivePrint},
   {(void*) "RVMPlugin", (void*)"primitivePrintStats", (void*)primitivePrintStats},
   {(void*) "RVMPlugin", (void*)"primitiveResetPerfCounters", (void*)primitiveResetPerfCounters},
+  {(void*) "RVMPlugin", (void*)"primitiveHardwareCounters", (void*)primitiveHardwareCounters},
+  {(void*) "RVMPlugin", (void*)"primitivePerformanceCounters", (void*)primitivePerformanceCounters},
   {(void*) "RVMPlugin", (void*)"primitiveCoreCount", (void*)primitiveCoreCount},
   {(void*) "RVMPlugin", (void*)"primitiveRunningProcessByCore", (void*)primitiveRunningProcessByCore},
 
@@ -872,6 +1080,16 @@ void* RVMPlugin_exports[][3] = {
   {(void*) "RVMPlugin", (void*)"primitiveSetExtraWordSelector", (void*)primitiveSetExtraWordSelector},
 
   {(void*) "RVMPlugin", (void*)"primitiveWriteSnapshot", (void*)primitiveWriteSnapshot},
+  {(void*) "RVMPlugin", (void*)"primitiveSetProcessSoftAffinity", (void*)primitiveSetProcessSoftAffinity},
+  {(void*) "RVMPlugin", (void*)"primitiveProcessMigrations", (void*)primitiveProcessMigrations},
+  {(void*) "RVMPlugin", (void*)"primitiveBackgroundSnapshot", (void*)primitiveBackgroundSnapshot},
+  {(void*) "RVMPlugin", (void*)"primitiveSafepointStatistics", (void*)primitiveSafepointStatistics},
+  {(void*) "RVMPlugin", (void*)"primitiveStartSamplingProfiler", (void*)primitiveStartSamplingProfiler},
+  {(void*) "RVMPlugin", (void*)"primitiveSampledStacks", (void*)primitiveSampledStacks},
+  {(void*) "RVMPlugin", (void*)"primitiveStartAllocationProfiler", (void*)primitiveStartAllocationProfiler},
+  {(void*) "RVMPlugin", (void*)"primitiveAllocationProfile", (void*)primitiveAllocationProfile},
+  {(void*) "RVMPlugin", (void*)"primitiveBenchmarkBegin", (void*)primitiveBenchmarkBegin},
+  {(void*) "RVMPlugin", (void*)"primitiveBenchmarkEnd", (void*)primitiveBenchmarkEnd},
 
   {(void*) "RVMPlugin", (void*)"primitiveEmergencySemaphore", (void*)primitiveEmergencySemaphore},
   {(void*) "RVMPlugin", (void*)"primitiveMicrosecondClock", (void*)primitiveMicrosecondClock},
@@ -15,18 +15,104 @@
 #include "headers.h"
 
 
+// Merges the rings, oldest entry first, and empties them.
 Oop Abstract_Tracer::get() {
-  int n = wrapped  ?  size  :  next;
+  int cursors[Max_Number_Of_Cores], ends[Max_Number_Of_Cores];
+  int n = 0;
+  FOR_ALL_RANKS(rank) {
+    int live = live_count(rank);
+    u_int64 c = rings[rank].count;
+    cursors[rank] = c > (u_int64)size  ?  int(c % size)  :  0; // oldest
+    ends[rank] = live;
+    n += live;
+  }
   Object_p r = array_class().as_object()->instantiateClass(n * elem_gotten_elem_size);
   void* p = r->firstIndexableField_for_primitives();
 
-  if (!wrapped)
-    copy_elements(0, p, 0, n, r);
-  else {
-    copy_elements( next,  p,            0,  size - next,  r);
-    copy_elements(    0,  p,  size - next,         next,  r);
+  for (int dst = 0;  dst < n;  ++dst) {
+    int oldest_rank = -1;
+    FOR_ALL_RANKS(rank)
+      if (ends[rank] > 0
+      &&  (oldest_rank < 0  ||  stamps[rank * size + cursors[rank]]  <  stamps[oldest_rank * size + cursors[oldest_rank]]))
+        oldest_rank = rank;
+    copy_elements(oldest_rank * size + cursors[oldest_rank], p, dst, 1, r);
+    cursors[oldest_rank] = (cursors[oldest_rank] + 1) % size;
+    --ends[oldest_rank];
   }
-  next = 0; wrapped = false;
+  FOR_ALL_RANKS(rank)
+    rings[rank].count = rings[rank].streamed = 0;
   return r->as_oop();
 }
 
+
+bool Abstract_Tracer::start_streaming(const char* file_name) {
+  stop_streaming();
+  FILE* f = fopen(file_name, "wb");
+  if (f == NULL) {
+    perror("trace stream file");
+    return false;
+  }
+  int32 header[2] = { 1, elem_byte_size };
+  fwrite("RVMTRACE", 1, 8, f);
+  fwrite(header, sizeof(header), 1, f);
+  FOR_ALL_RANKS(rank)
+    rings[rank].streamed = rings[rank].count;
+  streamed_entries_lost = 0;
+  stop_streaming_requested = false;
+  stream_file = f;
+  int err = pthread_create(&stream_thread, NULL, stream_thread_main, (void*)this);
+  if (err != 0) {
+    lprintf("Abstract_Tracer: could not start the streaming thread, %d\n", err);
+    stream_file = NULL;
+    fclose(f);
+    return false;
+  }
+  return true;
+}
+
+
+void Abstract_Tracer::stop_streaming() {
+  if (stream_file == NULL)
+    return;
+  stop_streaming_requested = true;
+  pthread_join(stream_thread, NULL);
+  stream_new_entries(true);
+  fclose(stream_file);
+  stream_file = NULL;
+}
+
+
+void* Abstract_Tracer::stream_thread_main(void* tracer) {
+  static const int period_usecs = 10000;
+  Abstract_Tracer* t = (Abstract_Tracer*)tracer;
+  while (!t->stop_streaming_requested) {
+    usleep(period_usecs);
+    t->stream_new_entries(false);
+  }
+  return NULL;
+}
+
+
+void Abstract_Tracer::stream_new_entries(bool all) {
+  FOR_ALL_RANKS(rank) {
+    Ring* r = &rings[rank];
+    u_int64 end = r->count;
+    if (!all  &&  end > 0)
+      --end; // may still be being written
+    if (end <= r->streamed)
+      continue;
+    if (end - r->streamed  >  (u_int64)size) {
+      streamed_entries_lost += int(end - size - r->streamed);
+      r->streamed = end - size;
+    }
+    for (;  r->streamed < end;  ++r->streamed) {
+      int i = rank * size  +  int(r->streamed % size);
+      int32 rank32 = rank;
+      fwrite(&rank32, sizeof(rank32), 1, stream_file);
+      fwrite(&stamps[i], sizeof(stamps[i]), 1, stream_file);
+      fwrite((char*)buffer + i * elem_byte_size, elem_byte_size, 1, stream_file);
+    }
+  }
+  fflush(stream_file);
+}
+
@@ -12,49 +12,87 @@
  ******************************************************************************/
 
 
+// Each core records into its own ring, so recording takes no lock and shares no cache line;
+// every entry is stamped with the cycle counter, and get() merges the rings by stamp.
+// A core only ever writes its own ring; readers may see an entry being written.
+//
+// When streaming, a background thread also appends new entries to a binary file:
+// a header { "RVMTRACE", int32 version, int32 elem_byte_size }, then records
+// { int32 rank, u_int64 cycles, elem_byte_size bytes of entry }, ordered per core
+// but not across cores. An entry is only streamed once its core has started the next one,
+// since until then it may be incomplete; a ring that wraps before the thread
+// gets to it loses entries, counted in streamed_entries_lost.
+
 class Abstract_Tracer {
  protected:
-  void* buffer;
-  int size;
-  int next;
-  bool wrapped;
+  void* buffer;     // a ring of size entries for each core in the group
+  u_int64* stamps;  // get_cycle_count when each entry was gotten
+  int size;         // entries per core
   int elem_byte_size;
   int elem_gotten_elem_size;
-  OS_Interface::Mutex mutex;
+
+  struct Ring {
+    u_int64 count;    // entries ever gotten, written only by the owning core
+    u_int64 streamed; // written only by the streaming thread
+  } __attribute__((aligned(64)));
+  Ring rings[Max_Number_Of_Cores];
+
+  FILE* stream_file; // NULL unless streaming
+  pthread_t stream_thread;
+  volatile bool stop_streaming_requested;
+  int streamed_entries_lost;
+
  public:
   void* operator new(size_t s)   { return Memory_Semantics::shared_malloc(s); }
   void  operator delete(void* p) { Memory_Semantics::shared_free(p); }
 
+  // n entries in all, shared out among the cores
   Abstract_Tracer(int n, int ebs, int eges)  {
     elem_byte_size = ebs;
     elem_gotten_elem_size = eges;
-    buffer = Memory_Semantics::shared_malloc( n * elem_byte_size );
-    size = n;
-    next = 0;
-    wrapped = false;
-    OS_Interface::mutex_init(&mutex);
+    const int cores = max(1, Logical_Core::group_size);
+    size = max(1, (n + cores - 1) / cores);
+    buffer = Memory_Semantics::shared_malloc( cores * size * elem_byte_size );
+    stamps = (u_int64*)Memory_Semantics::shared_malloc( cores * size * sizeof(u_int64) );
+    bzero(rings, sizeof(rings));
+    stream_file = NULL;
+    stop_streaming_requested = false;
+    streamed_entries_lost = 0;
+  }
+  ~Abstract_Tracer() {
+    stop_streaming();
+    Memory_Semantics::shared_free(buffer);
+    Memory_Semantics::shared_free(stamps);
   }
-  ~Abstract_Tracer() { Memory_Semantics::shared_free(buffer); }
 
   virtual Oop get();
 
+  bool start_streaming(const char* file_name);
+  void stop_streaming();
+  int get_streamed_entries_lost() { return streamed_entries_lost; }
+
  protected:
   virtual Oop array_class()  = 0;
   virtual void copy_elements(int src_offset, void* dst, int dst_offset, int num_elems, Object_p dst_obj)  = 0;
-  int end_of_live_data() { return wrapped ? size : next; }
-
 
-  int get_free_entry() {
-     OS_Interface::abort_if_error("Tracer", OS_Interface::mutex_lock(&mutex));
+  // entries are indexed across all rings; iterate with
+  // for (int i = 0;  i < capacity();  ++i)  if (is_live(i)) ...
+  int capacity() { return max(1, Logical_Core::group_size) * size; }
+  bool is_live(int i) { return u_int64(i % size)  <  rings[i / size].count; }
 
-    int r = next++;
-    if (next < size) ;
-    else if (next == size) { next = 0;  wrapped = true; }
-    else fatal("should never happen");
 
-     OS_Interface::abort_if_error("Tracer", OS_Interface::mutex_unlock(&mutex));
-    return r;
+  int get_free_entry() {
+    const int rank = Logical_Core::my_rank();
+    Ring* r = &rings[rank];
+    int i = rank * size  +  int(r->count % size);
+    stamps[i] = OS_Interface::get_cycle_count();
+    ++r->count;
+    return i;
   }
 
+ private:
+  static void* stream_thread_main(void*);
+  void stream_new_entries(bool all);
+  int live_count(int rank) { return int(min(rings[rank].count, (u_int64)size)); }
 };
 
@@ -0,0 +1,239 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+#include  <string>
+#include  <map>
+#include  <vector>
+#include  <algorithm> // before utils.h defines min and max
+
+#include "headers.h"
+
+int   Allocation_Profiler::sample_bytes = 0;
+bool  Allocation_Profiler::census_after_gc = false;
+char* Allocation_Profiler::file_name = NULL;
+Allocation_Profiler* Allocation_Profiler::profilers[Max_Number_Of_Cores];
+
+
+struct Allocation_Profiler::Tables {
+  struct Counts {
+    u_int64 count, bytes;
+    Counts() : count(0), bytes(0) {}
+  };
+  std::map<std::string, Counts> sites;  // samples and estimated bytes
+  std::map<std::string, Counts> census; // instances and bytes, as of the last full GC
+  std::map<std::pair<int, std::pair<int, bool> >, std::string> frame_names;
+  std::map<int, std::string> class_names;
+};
+
+
+Allocation_Profiler::Allocation_Profiler() {
+  bytes_until_sample = sample_bytes;
+  lock_word = 0;
+  censuses = 0;
+  tables = new Tables();
+}
+
+
+Allocation_Profiler* Allocation_Profiler::create_here() {
+  Allocation_Profiler* ap = new Allocation_Profiler();
+  OS_Interface::mem_fence();
+  profilers[Logical_Core::my_rank()] = ap;
+  return ap;
+}
+
+
+void Allocation_Profiler::start(int bytes, bool census) {
+  if (!is_supported())
+    return;
+  sample_bytes = bytes;
+  census_after_gc = census;
+  OS_Interface::mem_fence();
+  FOR_ALL_RANKS(r)
+    if (profilers[r] != NULL)
+      profilers[r]->bytes_until_sample = bytes; // racy, but only for this one sample
+}
+
+
+const char* Allocation_Profiler::class_name(Oop klass) {
+  std::string& name = tables->class_names[klass.bits()];
+  if (name.empty()) {
+    char b[256];
+    b[0] = '\0';
+    Sampling_Profiler::append_class_name(klass, b, sizeof(b));
+    name = b;
+  }
+  return name.c_str();
+}
+
+
+// "Foo>>bar @ 23", pc as in a context; the interpreter may be anywhere, even not interpreting yet.
+void Allocation_Profiler::append_site_name(Squeak_Interpreter* interp, char* buf, int buf_size) {
+  Memory_System* const ms = The_Memory_System();
+  Oop method = interp->roots._method;
+  Oop ctx = interp->roots._activeContext;
+  if (!method.is_mem()  ||  !ms->contains(method.as_object())  ||  !ctx.is_mem()  ||  !ms->contains(ctx.as_object())) {
+    Sampling_Profiler::append(buf, buf_size, "<vm>");
+    return;
+  }
+  bool is_block = ctx.as_object()->is_this_context_a_block_context();
+
+  std::pair<int, std::pair<int, bool> > key(method.bits(), std::pair<int, bool>(interp->roots.receiver.fetchClass().bits(), is_block));
+  std::string& name = tables->frame_names[key];
+  if (name.empty()) {
+    char b[256];
+    b[0] = '\0';
+    Sampling_Profiler::append_frame_name(method, interp->roots.receiver.fetchClass(), is_block, b, sizeof(b));
+    name = b;
+  }
+
+  // the internal ip is the fresher one while interpreting
+  Object_p m = method.as_object();
+  u_char* start = m->as_u_char_p() + Object::BaseHeaderSize;
+  u_char* end = start + m->byteLength();
+  u_char* ip = start <= interp->_localIP           &&  interp->_localIP           < end  ?  interp->_localIP
+             : start <= interp->_instructionPointer  &&  interp->_instructionPointer < end  ?  interp->_instructionPointer
+             : NULL;
+  Sampling_Profiler::append(buf, buf_size, "%s", name.c_str());
+  if (ip != NULL)
+    Sampling_Profiler::append(buf, buf_size, " @ %d", int(ip - start) + 2);
+}
+
+
+void Allocation_Profiler::take_sample(Object_p obj, int weight, u_int64 bytes) {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  lock();
+  char key[600];
+  snprintf(key, sizeof(key), "%s <- ", class_name(obj->fetchClass()));
+  append_site_name(interp, key, sizeof(key));
+  Tables::Counts& c = tables->sites[key];
+  c.count += weight;
+  c.bytes += bytes;
+  unlock();
+}
+
+
+// Runs on each core after a full GC, over the objects in its own heaps.
+void Allocation_Profiler::take_census_here() {
+  if (!is_supported())
+    return;
+  Allocation_Profiler* ap = here();
+  if (ap == NULL)
+    ap = create_here();
+  Safepoint_Ability sa(false);
+  std::map<int, Tables::Counts> by_class;
+  for (int mutability = 0;  mutability < Memory_System::max_num_mutabilities;  ++mutability) {
+    Multicore_Object_Heap* h = The_Memory_System()->heaps[Logical_Core::my_rank()][mutability];
+    FOR_EACH_OBJECT_IN_HEAP(h, obj) {
+      if (obj->isFreeObject()  ||  !obj->is_current_copy())
+        continue;
+      Tables::Counts& c = by_class[obj->fetchClass().bits()];
+      ++c.count;
+      c.bytes += obj->total_byte_size();
+    }
+  }
+  ap->lock();
+  ap->tables->census.clear();
+  for (std::map<int, Tables::Counts>::iterator i = by_class.begin();  i != by_class.end();  ++i) {
+    Tables::Counts& c = ap->tables->census[ap->class_name(Oop::from_bits(i->first))];
+    c.count += i->second.count;
+    c.bytes += i->second.bytes;
+  }
+  ++ap->censuses;
+  ap->unlock();
+}
+
+
+void Allocation_Profiler::objects_have_moved() {
+  lock();
+  tables->frame_names.clear();
+  tables->class_names.clear();
+  unlock();
+}
+
+
+static bool more_bytes(const std::pair<std::string, std::pair<u_int64, u_int64> >& a,
+                       const std::pair<std::string, std::pair<u_int64, u_int64> >& b) {
+  return a.second.second > b.second.second;
+}
+
+
+static void append_sorted(std::string& out, const char* title, const char* columns,
+                          std::map<std::string, std::pair<u_int64, u_int64> >& totals) {
+  std::vector<std::pair<std::string, std::pair<u_int64, u_int64> > > v(totals.begin(), totals.end());
+  std::sort(v.begin(), v.end(), more_bytes);
+  char line[64];
+  out += title;
+  out += columns;
+  for (size_t i = 0;  i < v.size();  ++i) {
+    snprintf(line, sizeof(line), "%12llu %10llu ", v[i].second.second, v[i].second.first);
+    out += line;
+    out += v[i].first;
+    out += "\n";
+  }
+}
+
+
+// Sites by estimated bytes, then the census summed over the cores, by bytes.
+char* Allocation_Profiler::profile_as_malloced_string(bool reset) {
+  std::map<std::string, std::pair<u_int64, u_int64> > sites, census;
+  int censuses = 0;
+  FOR_ALL_RANKS(r) {
+    Allocation_Profiler* ap = profilers[r];
+    if (ap == NULL)  continue;
+    ap->lock();
+    for (std::map<std::string, Tables::Counts>::iterator i = ap->tables->sites.begin();  i != ap->tables->sites.end();  ++i) {
+      sites[i->first].first  += i->second.count;
+      sites[i->first].second += i->second.bytes;
+    }
+    for (std::map<std::string, Tables::Counts>::iterator i = ap->tables->census.begin();  i != ap->tables->census.end();  ++i) {
+      census[i->first].first  += i->second.count;
+      census[i->first].second += i->second.bytes;
+    }
+    censuses = max(censuses, ap->censuses);
+    if (reset)
+      ap->tables->sites.clear();
+    ap->unlock();
+  }
+  std::string out;
+  char title[100];
+  snprintf(title, sizeof(title), "allocation sites, a sample every %d bytes:\n", sample_bytes);
+  append_sorted(out, title, "       bytes    samples class <- site\n", sites);
+  snprintf(title, sizeof(title), "\nlive objects after full GC %d:\n", censuses);
+  append_sorted(out, title, "       bytes  instances class\n", census);
+  return strdup(out.c_str());
+}
+
+
+Oop Allocation_Profiler::profile(bool reset) {
+  char* s = profile_as_malloced_string(reset);
+  Oop r = Object::makeString(s)->as_oop();
+  free(s);
+  return r;
+}
+
+
+void Allocation_Profiler::write_file_if_requested() {
+  if (file_name == NULL  ||  !is_supported())
+    return;
+  FILE* f = fopen(file_name, "w");
+  if (f == NULL) {
+    perror("allocation profile file");
+    return;
+  }
+  char* s = profile_as_malloced_string(false);
+  fputs(s, f);
+  fclose(f);
+  free(s);
+}
+
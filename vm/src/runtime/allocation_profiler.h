@@ -0,0 +1,89 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// Which classes get allocated where, and which classes fill the heap.
+// Sampling: every sample_bytes bytes a core allocates through Multicore_Object_Heap::allocate,
+// the object that crosses the mark is charged to its site: its class, and the method,
+// receiver class and bytecode pc the interpreter is at. A sample stands for sample_bytes bytes,
+// or a multiple for a big object, so the estimated bytes per site add up to what was allocated.
+// Census: after each full GC every core walks its own heaps, in postGCAction_here, and counts
+// the live instances and bytes per class.
+// Names are made when sampling or counting, while the Oops are good, and cached till objects move.
+// Each core keeps its own tables under its own lock; collecting sums them by name.
+// Threads only, since the collector reads every core's tables.
+// See primitiveStartAllocationProfiler, primitiveAllocationProfile, and -allocation_profile.
+
+class Allocation_Profiler {
+public:
+  static const int default_sample_bytes = 512 * 1024;
+  static int   sample_bytes;    // threadsafe config value, 0 when not sampling
+  static bool  census_after_gc; // threadsafe config value
+  static char* file_name;       // -allocation_profile: sample and census from start, written here at quit
+
+private:
+  static Allocation_Profiler* profilers[Max_Number_Of_Cores]; // by rank, once the core has allocated
+
+  int bytes_until_sample;
+  int lock_word;
+  int censuses;
+
+  struct Tables; // sites and census by name, and a cache of names till objects move
+  Tables* tables;
+
+  Allocation_Profiler();
+  static Allocation_Profiler* create_here();
+
+  void lock() {
+    while (!OS_Interface::atomic_compare_and_swap(&lock_word, 0, 1))
+      ;
+  }
+  void unlock() {
+    OS_Interface::mem_fence();
+    lock_word = 0;
+  }
+
+  void take_sample(Object_p, int weight, u_int64 bytes);
+  void append_site_name(Squeak_Interpreter*, char* buf, int buf_size);
+  const char* class_name(Oop klass);
+  static char* profile_as_malloced_string(bool reset);
+
+public:
+  static bool is_supported() { return Using_Threads; }
+  static Allocation_Profiler* here() { return profilers[Logical_Core::my_rank()]; }
+
+  static void note_allocation(Object_p obj, int bytes) {
+    Allocation_Profiler* ap = here();
+    if (ap == NULL)
+      ap = create_here();
+    if ((ap->bytes_until_sample -= bytes) > 0)
+      return;
+    const int every = sample_bytes; // stop may zero it meanwhile
+    if (every <= 0)
+      return;
+    int weight = 0;
+    do {
+      ap->bytes_until_sample += every;
+      ++weight;
+    } while (ap->bytes_until_sample <= 0);
+    ap->take_sample(obj, weight, u_int64(weight) * every);
+  }
+
+  static void start(int sample_bytes, bool census);
+  static void take_census_here();
+  void objects_have_moved();
+
+  static Oop  profile(bool reset);
+  static void write_file_if_requested();
+};
+
@@ -25,7 +25,8 @@ Oop Execution_Tracer::array_class() { return The_Squeak_Interpreter()->splObj(Sp
 
 void Execution_Tracer::do_all_roots(Oop_Closure* oc) {
   oc->value(&ctx, (Object_p)NULL);
-  for (int i = 0;  i < end_of_live_data();  ++i) {
+  for (int i = 0;  i < capacity();  ++i) {
+    if (!is_live(i))  continue;
     bc* bcp = (bc*)entry_ptr(i);  proc* procp = (proc*)bcp;
     switch (bcp->kind) {
         default: fatal(); break;
@@ -74,14 +75,15 @@ void Execution_Tracer::copy_elements(int src_offset, void* dst,
   //        " num_elems %d, dst_obj 0x%x, next %d\n",
   //        src_offset, buffer, dst, dst_offset, num_elems, (Object*)dst_obj, next);
 
-  Oop* dst_oop = (Oop*)dst  +  dst_offset * e_N;
+  Oop* const first_dst_oop = (Oop*)dst  +  dst_offset * e_N;
+  Oop* dst_oop = first_dst_oop;
   // zero-fill for GC sake
   for (int i = 0;  i < num_elems;  ++i)
     for (int j = 0;  j < e_N;  ++j)
       dst_oop[i * e_N  +  j] = Oop::from_int(0);
 
   for (int i = 0;  i < num_elems;  ++i, dst_oop += e_N) {
-    bc* bcp = (bc*)entry_ptr(i);  gc* gcp = (gc*)bcp;  proc* procp = (proc*)bcp; rcved_interp* rip = (rcved_interp*)bcp; aux* auxp = (aux*)bcp;
+    bc* bcp = (bc*)entry_ptr(src_offset + i);  gc* gcp = (gc*)bcp;  proc* procp = (proc*)bcp; rcved_interp* rip = (rcved_interp*)bcp; aux* auxp = (aux*)bcp;
     dst_oop[e_kind] = Oop::from_int(bcp->kind);
     switch (bcp->kind) {
       default: fatal(); break;
@@ -123,7 +125,7 @@ void Execution_Tracer::copy_elements(int src_offset, void* dst,
         break;
     }
   }
-  dst_obj->my_heap()->check_multiple_stores_for_generations_only(dst_oop, num_elems * e_N);
+  dst_obj->my_heap()->check_multiple_stores_for_generations_only(first_dst_oop, num_elems * e_N);
 }
 
 
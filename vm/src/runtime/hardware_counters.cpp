@@ -0,0 +1,218 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+# include "headers.h"
+
+# if On_Intel_Linux
+# include <linux/perf_event.h>
+# include <sys/syscall.h>
+# include <sys/ioctl.h>
+# endif
+
+bool Hardware_Counters::use_hardware_counters = false;
+Hardware_Counters* Hardware_Counters::_all_hardware_counters[Max_Number_Of_Cores] = { NULL };
+
+
+Hardware_Counters::Hardware_Counters() {
+  group_fd = -1;
+  open_count = 0;
+  phase = interpreter;
+  for (int e = 0;  e < event_count;  ++e) {
+    slot_of_event[e] = -1;
+    user_page_of_event[e] = NULL;
+  }
+  bzero(at_last_switch, sizeof(at_last_switch));
+  bzero(totals, sizeof(totals));
+}
+
+
+// Called by each core's thread as it starts interpreting.
+void Hardware_Counters::start_here() {
+  if (!use_hardware_counters  ||  !is_supported()  ||  here() != NULL)
+    return;
+  Hardware_Counters* hc = new Hardware_Counters();
+  if (!hc->open_group()) {
+    delete hc;
+    return;
+  }
+  hc->read_group(hc->at_last_switch);
+  _all_hardware_counters[Logical_Core::my_rank()] = hc;
+}
+
+
+bool Hardware_Counters::open_group() {
+# if On_Intel_Linux
+  // same order as FOR_ALL_HARDWARE_EVENTS_DO
+  static const struct { u_int32 type;  u_int64 config; } events[event_count] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL
+                          | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                          | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16) },
+  };
+  for (int e = 0;  e < event_count;  ++e) {
+    struct perf_event_attr attr;
+    bzero(&attr, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[e].type;
+    attr.config = events[e].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.disabled = group_fd == -1; // the leader starts the group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd = syscall(__NR_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */, group_fd, 0);
+    if (fd < 0) {
+      if (group_fd == -1) {
+        lprintf("Hardware_Counters: cannot count instructions on core %d, %s; see /proc/sys/kernel/perf_event_paranoid\n",
+                Logical_Core::my_rank(), strerror(errno));
+        return false;
+      }
+      continue;
+    }
+    if (group_fd == -1)  group_fd = fd;
+    slot_of_event[e] = open_count++;
+    void* page = mmap(NULL, getpagesize(), PROT_READ, MAP_SHARED, fd, 0);
+    user_page_of_event[e] = page == MAP_FAILED  ?  NULL  :  page;
+  }
+  ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+# else
+  return false;
+# endif
+}
+
+
+void Hardware_Counters::read_group(u_int64 values[event_count]) {
+  if (read_group_in_user_mode(values))
+    return;
+  u_int64 buf[1 + event_count]; // { nr, value... }
+  if (read(group_fd, buf, sizeof(buf)) < (ssize_t)sizeof(u_int64)) {
+    for (int e = 0;  e < event_count;  ++e)  values[e] = at_last_switch[e];
+    return;
+  }
+  for (int e = 0;  e < event_count;  ++e)
+    values[e] = slot_of_event[e] < 0  ?  0  :  buf[1 + slot_of_event[e]];
+}
+
+
+// Reads each counter with rdpmc, as the kernel documents for perf_event_mmap_page:
+// retry while the kernel updates the page, and give up if the counter is not on the PMU right now.
+bool Hardware_Counters::read_group_in_user_mode(u_int64 values[event_count]) {
+# if On_Intel_Linux
+  for (int e = 0;  e < event_count;  ++e) {
+    if (slot_of_event[e] < 0) {
+      values[e] = 0;
+      continue;
+    }
+    volatile struct perf_event_mmap_page* pc = (volatile struct perf_event_mmap_page*)user_page_of_event[e];
+    if (pc == NULL)
+      return false;
+    u_int32 seq;
+    u_int64 count;
+    do {
+      seq = pc->lock;
+      __asm__ __volatile__("" ::: "memory");
+      u_int32 index = pc->index;
+      if (!pc->cap_user_rdpmc  ||  index == 0)
+        return false;
+      u_int32 lo, hi;
+      __asm__ __volatile__("rdpmc" : "=a" (lo), "=d" (hi) : "c" (index - 1));
+      int shift = 64 - pc->pmc_width;
+      int64 pmc = int64((u_int64(hi) << 32  |  lo)  <<  shift)  >>  shift;
+      count = pc->offset + pmc;
+      __asm__ __volatile__("" ::: "memory");
+    } while (pc->lock != seq);
+    values[e] = count;
+  }
+  return true;
+# else
+  return false;
+# endif
+}
+
+
+// Charges the counts since the last switch to the phase being left; answers it.
+Hardware_Counters::Phase Hardware_Counters::switch_to(Phase p) {
+  Phase old = phase;
+  if (p == old)
+    return old;
+  u_int64 now[event_count];
+  read_group(now);
+  for (int e = 0;  e < event_count;  ++e) {
+    totals[old][e] += now[e] - at_last_switch[e];
+    at_last_switch[e] = now[e];
+  }
+  phase = p;
+  return old;
+}
+
+
+void Hardware_Counters::print() {
+  if (!use_hardware_counters)
+    return;
+
+  fprintf(stdout, "Hardware Counters:\n");
+  fprintf(stdout, "\t %-12s", "");
+# define PRINT(name) fprintf(stdout, " %16s", #name);
+  FOR_ALL_HARDWARE_EVENTS_DO(PRINT)
+# undef PRINT
+  fprintf(stdout, "\n");
+
+  FOR_ALL_RANKS(r) {
+    Hardware_Counters* hc = _all_hardware_counters[r];
+    if (hc == NULL)  continue;
+    fprintf(stdout, "\tRank %d:\n", r);
+# define PRINT(name) \
+    fprintf(stdout, "\t %-12s", #name); \
+    for (int e = 0;  e < event_count;  ++e) \
+      fprintf(stdout, " %16lld", hc->totals[name][e]); \
+    fprintf(stdout, "\n");
+    FOR_ALL_HARDWARE_COUNTER_PHASES_DO(PRINT)
+# undef PRINT
+  }
+}
+
+
+void Hardware_Counters::reset() {
+  FOR_ALL_RANKS(r)
+    if (_all_hardware_counters[r] != NULL)
+      bzero(_all_hardware_counters[r]->totals, sizeof(_all_hardware_counters[r]->totals));
+}
+
+
+// Answers, per core, nil if it is not counting, else per phase in FOR_ALL_HARDWARE_COUNTER_PHASES_DO order,
+// the counts in FOR_ALL_HARDWARE_EVENTS_DO order.
+Oop Hardware_Counters::get_stats() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  int s = interp->makeArrayStart();
+  FOR_ALL_RANKS(r) {
+    Hardware_Counters* hc = _all_hardware_counters[r];
+    if (hc == NULL) {
+      PUSH_FOR_MAKE_ARRAY(interp->roots.nilObj);
+      continue;
+    }
+    int rs = interp->makeArrayStart();
+    for (int p = 0;  p < phase_count;  ++p) {
+      int ps = interp->makeArrayStart();
+      for (int e = 0;  e < event_count;  ++e)
+        PUSH_POSITIVE_64_BIT_INT_FOR_MAKE_ARRAY(hc->totals[p][e]);
+      PUSH_FOR_MAKE_ARRAY(interp->makeArray(ps));
+    }
+    PUSH_FOR_MAKE_ARRAY(interp->makeArray(rs));
+  }
+  return interp->makeArray(s);
+}
+
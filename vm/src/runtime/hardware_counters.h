@@ -0,0 +1,87 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// Hardware event counts per core from Linux perf_event_open, unlike the software
+// Performance_Counters, and counted only with -hw_counters.
+// Each core opens one group of counters on its own thread. The counts are attributed to the phase
+// the core is in: a Hardware_Counters_Phase reads the group on entry and exit, and charges
+// the difference to its phase; the rest is interpreter.
+// An event the machine does not have reads as 0.
+// Phases switch around every message sent and handled, so the group is read with rdpmc from
+// the pages the kernel maps for each counter, and with read() only when the kernel does not allow
+// that or has taken the counter off the PMU meanwhile.
+// See primitiveHardwareCounters, and primitivePrintStats.
+
+class Hardware_Counters {
+public:
+  static bool use_hardware_counters; // threadsafe readonly config value
+
+# define FOR_ALL_HARDWARE_EVENTS_DO(template) \
+  template(instructions) \
+  template(cache_misses) \
+  template(branch_misses) \
+  template(llc_loads)
+
+# define FOR_ALL_HARDWARE_COUNTER_PHASES_DO(template) \
+  template(interpreter) \
+  template(gc) \
+  template(messaging) \
+  template(scheduler)
+
+# define DEFINE_HARDWARE_COUNTERS_ENUM(name) name,
+  enum Event { FOR_ALL_HARDWARE_EVENTS_DO(DEFINE_HARDWARE_COUNTERS_ENUM) event_count };
+  enum Phase { FOR_ALL_HARDWARE_COUNTER_PHASES_DO(DEFINE_HARDWARE_COUNTERS_ENUM) phase_count };
+# undef DEFINE_HARDWARE_COUNTERS_ENUM
+
+private:
+  static Hardware_Counters* _all_hardware_counters[Max_Number_Of_Cores];
+
+  int group_fd;
+  int slot_of_event[event_count]; // in a read of the group, -1 if not counting it
+  void* user_page_of_event[event_count]; // a struct perf_event_mmap_page, NULL if not mapped
+  int open_count;
+  Phase phase;
+  u_int64 at_last_switch[event_count];
+  u_int64 totals[phase_count][event_count];
+
+  Hardware_Counters();
+  bool open_group();
+  void read_group(u_int64 values[event_count]);
+  bool read_group_in_user_mode(u_int64 values[event_count]);
+
+public:
+  static bool is_supported() { return On_Intel_Linux  &&  Using_Threads; }
+  static void start_here();
+  static Hardware_Counters* here() { return _all_hardware_counters[Logical_Core::my_rank()]; }
+
+  Phase switch_to(Phase);
+
+  static void print();
+  static void reset();
+  static Oop get_stats();
+};
+
+
+class Hardware_Counters_Phase {
+  Hardware_Counters* counters;
+  Hardware_Counters::Phase outer;
+public:
+  Hardware_Counters_Phase(Hardware_Counters::Phase p) {
+    counters = Hardware_Counters::use_hardware_counters  ?  Hardware_Counters::here()  :  NULL;
+    outer = p; // unused without counters
+    if (counters != NULL)  outer = counters->switch_to(p);
+  }
+  ~Hardware_Counters_Phase() { if (counters != NULL)  counters->switch_to(outer); }
+};
+
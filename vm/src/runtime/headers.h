@@ -34,6 +34,7 @@
 # include <fcntl.h>
 # include <unistd.h>
 # include <signal.h>
+# include <sys/wait.h>
 # include <errno.h>
 
 # if On_Tilera
@@ -58,6 +59,7 @@
 #  include "synced_queue.h"
 #  include "buffered_channel.h"
 #  include "buffered_channel_debug.h"
+#  include "message_ring.h"
 # endif
 
 # if On_iOS
@@ -162,6 +164,7 @@
 # include "message_or_ack_request.h"
 # include "deferred_request.h"
 # include "interactions.h"
+# include "coalesced_broadcasts.h"
 
 # include "timeout_timer.h"
 # include "timeout_deferral.h"
@@ -172,9 +175,13 @@
 
 # include "abstract_mutex.h"
 # include "safepoint.h"
+# include "safepoint_stats.h"
 # include "scheduler_mutex.h"
+# include "priority_bitmap.h"
+# include "run_queues.h"
 # include "semaphore_mutex.h"
 
+# include "snapshot_writer.h"
 # include "abstract_object_heap.h"
 # include "multicore_object_heap.h"
 
@@ -194,6 +201,12 @@
 # include "execution_tracer.h"
 # include "triggerable_execution_tracer.h"
 # include "profiling_tracer.h"
+# include "sampling_profiler.h"
+# include "timeline.h"
+# include "hardware_counters.h"
+# include "allocation_profiler.h"
+# include "micro_benchmarks.h"
+# include "image_benchmark.h"
 # include "gc_debugging_tracer.h"
 
 
@@ -205,6 +218,8 @@
 # include "dummy_object_table.h"
 
 # include "memory_system.h"
+# include "gc_log.h"
+# include "synthetic_heap.h"
 
 # include "runtime_tester.h"
 
@@ -221,6 +236,7 @@
 # include "squeak_interpreter.h"
 
 # include "squeak_image_reader.h"
+# include "minimal_image.h"
 
 
 # include "gc_oop_stack.h"
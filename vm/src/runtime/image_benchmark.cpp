@@ -0,0 +1,174 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+# include "headers.h"
+
+char* Image_Benchmark::expression = NULL;
+int   Image_Benchmark::iterations = 10;
+int   Image_Benchmark::warmup = 2;
+char* Image_Benchmark::output_file = NULL;
+int   Image_Benchmark::timeout_secs = 600;
+
+char  Image_Benchmark::script_name[] = "/tmp/omnivm-bench-XXXXXX.st";
+Image_Benchmark::Iteration* Image_Benchmark::results = NULL;
+int   Image_Benchmark::done = 0;
+bool  Image_Benchmark::in_warmup = false;
+Image_Benchmark::Snapshot Image_Benchmark::begin;
+
+
+void Image_Benchmark::Snapshot::take() {
+  usecs = monotonic_nsecs() / 1000; // a step of the wall clock would skew the iteration
+  Memory_System* const ms = The_Memory_System();
+  gc_ms = ms->get_gcMilliseconds();
+  gcs   = ms->get_gcCount();
+  safepoints = Performance_Counters::total_acquire_safepoint();
+  bytecodes  = Performance_Counters::total_bytecodes_executed();
+}
+
+
+// Chunk format: a ! in the expression must be doubled.
+bool Image_Benchmark::write_script() {
+  int fd = mkstemps(script_name, 3);
+  if (fd < 0) {
+    perror("benchmark script");
+    return false;
+  }
+  FILE* f = fdopen(fd, "w");
+  fprintf(f, "\"Written by the VM for -bench\"!\n\n");
+  fprintf(f, "!UndefinedObject methodsFor: 'omnivm benchmark'!\n");
+  fprintf(f, "omniVMBenchmarkBegin: isWarmup\n"
+             "\t<primitive: 'primitiveBenchmarkBegin' module: 'RVMPlugin'>\n"
+             "\t^ self primitiveFailed!\n");
+  fprintf(f, "omniVMBenchmarkEnd\n"
+             "\t<primitive: 'primitiveBenchmarkEnd' module: 'RVMPlugin'>\n"
+             "\t^ self primitiveFailed! !\n\n");
+  fprintf(f, "| block |\nblock := [");
+  for (const char* p = expression;  *p;  ++p) {
+    if (*p == '!')  fputc('!', f);
+    fputc(*p, f);
+  }
+  fprintf(f, "].\n");
+  fprintf(f, "1 to: %d do: [:i | nil omniVMBenchmarkBegin: true.  block value.  nil omniVMBenchmarkEnd].\n", warmup);
+  fprintf(f, "1 to: %d do: [:i | nil omniVMBenchmarkBegin: false.  block value.  nil omniVMBenchmarkEnd]!\n", iterations);
+  bool ok = fclose(f) == 0;
+  if (!ok)
+    perror("benchmark script");
+  return ok;
+}
+
+
+// Writes the script and passes it to the image as its document, right after the image name.
+void Image_Benchmark::prepare(int& argc, char**& argv) {
+  if (iterations < 1)
+    fatal("-iterations must be at least 1");
+  if (warmup < 0)
+    warmup = 0;
+  results = new Iteration[iterations];
+  Performance_Counters::enabled = true;
+  if (!write_script())
+    fatal("cannot write the benchmark script");
+
+  char** new_argv = new char*[argc + 2];
+  new_argv[0] = argv[0];
+  new_argv[1] = argv[1];
+  new_argv[2] = script_name;
+  for (int i = 2;  i <= argc;  ++i)
+    new_argv[i + 1] = argv[i];
+  ++argc;
+  argv = new_argv;
+
+  pthread_t watchdog;
+  if (timeout_secs > 0  &&  pthread_create(&watchdog, NULL, watchdog_main, NULL) == 0)
+    pthread_detach(watchdog);
+}
+
+
+void* Image_Benchmark::watchdog_main(void*) {
+  u_int64 deadline = monotonic_nsecs()  +  u_int64(timeout_secs) * 1000000000ULL;
+  while (monotonic_nsecs() < deadline)
+    sleep(1);
+
+  fprintf(stderr, "-bench: no result after %d seconds, %d of %d iterations done; "
+                  "does the expression compile and run without errors?\n",
+          timeout_secs, done, iterations);
+  FILE* f = output_file == NULL  ?  stdout  :  fopen(output_file, "w");
+  if (f != NULL) {
+    fprintf(f, "{\"expression\": ");
+    write_escaped(f, expression);
+    fprintf(f, ", \"error\": \"timed out after %d seconds\", \"iterations_done\": %d}\n", timeout_secs, done);
+    fflush(f);
+  }
+  unlink(script_name);
+  _exit(1);
+  return NULL;
+}
+
+
+void Image_Benchmark::begin_iteration(bool is_warmup) {
+  in_warmup = is_warmup;
+  begin.take();
+}
+
+
+void Image_Benchmark::end_iteration() {
+  if (in_warmup  ||  done >= iterations)
+    return;
+  results[done].begin = begin;
+  results[done].end.take();
+  if (++done < iterations)
+    return;
+
+  FILE* f = output_file == NULL  ?  stdout  :  fopen(output_file, "w");
+  if (f == NULL) {
+    perror("benchmark output");
+    f = stdout;
+  }
+  write_report(f);
+  if (f != stdout)
+    fclose(f);
+  unlink(script_name);
+  ioExit();
+}
+
+
+void Image_Benchmark::write_escaped(FILE* f, const char* s) {
+  fputc('"', f);
+  for (;  *s;  ++s)
+    if (*s == '"'  ||  *s == '\\')    fprintf(f, "\\%c", *s);
+    else if ((unsigned char)*s < ' ')  fprintf(f, "\\u%04x", *s);
+    else                               fputc(*s, f);
+  fputc('"', f);
+}
+
+
+void Image_Benchmark::write_report(FILE* f) {
+  fprintf(f, "{\"expression\": ");
+  write_escaped(f, expression);
+  fprintf(f, ", \"cores\": %d, \"warmup\": %d, \"iterations\": [", Logical_Core::group_size, warmup);
+  u_int64 total_usecs = 0, min_usecs = ~0ULL, max_usecs = 0;
+  for (int i = 0;  i < iterations;  ++i) {
+    Snapshot& b = results[i].begin;
+    Snapshot& e = results[i].end;
+    u_int64 usecs = e.usecs - b.usecs;
+    total_usecs += usecs;
+    min_usecs = min(min_usecs, usecs);
+    max_usecs = max(max_usecs, usecs);
+    fprintf(f, "%s\n  {\"wall_ms\": %.3f, \"gc_ms\": %u, \"gcs\": %u, \"safepoints\": %llu, \"bytecodes\": %llu}",
+            i ? "," : "", usecs / 1000.0, e.gc_ms - b.gc_ms, e.gcs - b.gcs, e.safepoints - b.safepoints, e.bytecodes - b.bytecodes);
+  }
+  fprintf(f, "],\n \"wall_ms\": {\"min\": %.3f, \"mean\": %.3f, \"max\": %.3f}}\n",
+          min_usecs / 1000.0, total_usecs / 1000.0 / iterations, max_usecs / 1000.0);
+  fflush(f);
+}
+
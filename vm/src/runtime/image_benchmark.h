@@ -0,0 +1,64 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// Runs a Smalltalk expression headless, warmup + iterations times, and reports each iteration as JSON:
+// wall time, full GC time and count, safepoints and bytecodes executed, then quits.
+// -bench "expr" [-iterations N] [-warmup M] [-bench_output file] [-bench_timeout secs]
+// The VM cannot compile the expression itself, so it writes a script for the image to file in,
+// passed as the image's document argument (getAttribute: 2), as a plain Squeak image files in
+// a .st document at startup. The script adds two methods to UndefinedObject that call
+// primitiveBenchmarkBegin and primitiveBenchmarkEnd around each evaluation.
+// Those run on main, which also writes the report and quits after the last iteration.
+// Counts bytecodes and safepoints with Performance_Counters, so turns them on.
+// An expression that does not compile, or raises an error, leaves the image waiting for a user
+// who is not there, so a watchdog thread reports failure and exits 1 after timeout_secs.
+
+class Image_Benchmark {
+public:
+  static char* expression;  // -bench
+  static int   iterations;  // -iterations
+  static int   warmup;      // -warmup
+  static char* output_file; // -bench_output, else stdout
+  static int   timeout_secs; // -bench_timeout, for everything from startup to the report
+
+private:
+  struct Snapshot {
+    u_int64 usecs;
+    u_int32 gc_ms, gcs;
+    u_int64 safepoints, bytecodes;
+    void take();
+  };
+  struct Iteration {
+    Snapshot begin, end;
+  };
+
+  static char      script_name[];
+  static Iteration* results;
+  static int       done;       // measured iterations finished
+  static bool      in_warmup;
+  static Snapshot  begin;
+
+  static bool write_script();
+  static void* watchdog_main(void*);
+  static void write_escaped(FILE*, const char*);
+  static void write_report(FILE*);
+
+public:
+  static bool is_requested() { return expression != NULL; }
+  static void prepare(int& argc, char**& argv);
+
+  static void begin_iteration(bool is_warmup);
+  static void end_iteration();
+};
+
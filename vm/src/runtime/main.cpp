@@ -109,7 +109,18 @@ template("-profile_after",      The_Squeak_Interpreter()->set_profile_after(NUMB
 template("-quit_after",         The_Squeak_Interpreter()->set_quit_after(NUMBER),    "N") \
 template("-round_robin_period", Memory_System::set_round_robin_period(NUMBER),    "N") \
 template("-run_mask",           The_Squeak_Interpreter()->set_run_mask(NUMBER64),    "N") \
+template("-affinity_delay",     Run_Queues::affinity_delay_nsecs = NUMBER64,      "nanoseconds") \
 template("-trace",              set_trace_file(STRING),                           "file-name") \
+template("-sample_profile",     Sampling_Profiler::file_name = STRING,            "file-name") \
+template("-allocation_profile", Allocation_Profiler::file_name = STRING,          "file-name") \
+template("-gc_log",             GC_Log::file_name = STRING,                       "file-name") \
+template("-timeline",           Timeline::file_name = STRING,                     "file-name") \
+template("-bench",              Image_Benchmark::expression = STRING,             "expression") \
+template("-iterations",         Image_Benchmark::iterations = NUMBER,             "N") \
+template("-warmup",             Image_Benchmark::warmup = NUMBER,                 "N") \
+template("-bench_output",       Image_Benchmark::output_file = STRING,            "file-name") \
+template("-bench_timeout",      Image_Benchmark::timeout_secs = NUMBER,           "seconds, 0 for none") \
+template("-synthetic_heap",     Synthetic_Heap::spec = STRING,                    "name=value,...") \
 template("-num_chips",          The_Squeak_Interpreter()->set_num_chips(NUMBER),    "N")
 
 
@@ -117,13 +128,25 @@ template("-num_chips",          The_Squeak_Interpreter()->set_num_chips(NUMBER),
 # define FOR_ALL_BOOLEAN_ARGS_DO(template) \
 template("-dont_replicate_all",    Memory_System::replicate_all = false, "not replicating everything") \
 template("-eschew_huge_pages",  Memory_System::use_huge_pages = false, "not using huge pages") \
+template("-thp",                Memory_System::use_transparent_huge_pages = true, "using an anonymous heap mapping with transparent huge pages") \
+template("-background_snapshots", Memory_System::allow_background_snapshots = true, "using a private heap mapping so that snapshots can be written by a forked child") \
+template("-message_safepoints", Safepoint_Tracker::use_shared_memory = false, "negotiating safepoints with messages to the main core") \
+template("-safepoint_stats",    Safepoint_Stats::print_at_exit = true, "printing time to safepoint and hold time per reason at quit") \
+template("-perf_counters",      Performance_Counters::enabled = true, "counting bytecodes, sends, method cache hits, contexts, messages and the like per core from the start") \
+template("-hw_counters",        Hardware_Counters::use_hardware_counters = true, "counting cache misses, branch misses, instructions and LLC loads per core and phase with perf_event_open") \
+template("-async_main_prims",   Interactions::run_remote_primitives_asynchronously = true, "letting a core run other processes while the main core runs a primitive for it") \
+template("-no_coalesced_broadcasts", Coalesced_Broadcasts::use_coalesced_broadcasts = false, "sending a message to every core for each method cache flush and broadcast interpreter datum") \
+template("-no_run_queues",      Run_Queues::use_run_queues = false, "always walking the scheduler's process lists to find a process to run") \
+template("-numa",               Memory_System::use_numa = true, "placing each core's heaps, object table segments and message queue on its NUMA node") \
 template("-headless",           headless = 1, "headless") \
+template("-microbench",         Micro_Benchmarks::run_instead_of_image = true, "timing the VM's hot paths instead of running the image, then quitting") \
 template("-make_checkpoint",    The_Squeak_Interpreter()->set_make_checkpoint(true), "making checkpoint") \
 template("-no_fence",           The_Squeak_Interpreter()->set_fence(false), "not fencing memory on control transfers") \
 template("-print_moves_to_read_write",  The_Squeak_Interpreter()->set_print_moves_to_read_write(true), "printing moves to read_write heaps") \
 template("-replicate_methods",  Memory_System::replicate_methods = true, "replicating methods") \
 template("-use_checkpoint",     The_Squeak_Interpreter()->set_use_checkpoint(true), "using checkpoint") \
 template("-replicate_OT",       Segmented_Object_Table::replicate = true, "let hardware replicate the object table") \
+template("-serial_image_load",  Squeak_Image_Reader::load_in_parallel = false, "reading the image and sending each object to its core one at a time") \
 template("-print_gc",           Abstract_Mark_Sweep_Collector::print_gc = true, "Print GC") \
 template("-version",            print_version_info(), "Print full version information") \
 template("-use_cpu_ms",         The_Squeak_Interpreter()->set_use_cpu_ms(true), "use CPU time instead of elapsed time")
@@ -220,6 +243,9 @@ static void process_arguments(int& argc, char**& argv) {
   if (!have_set_core_count)
     Logical_Core::num_cores = 1;
 
+  if (argc < 2  &&  Synthetic_Heap::is_requested())
+    return; // main boots from a minimal image
+  
   if (argc < 2)  // looks like the image parameter is missing
     usage(argv);
   
@@ -283,6 +309,10 @@ void begin_interpretation() {
   
   assert_always(The_Squeak_Interpreter()->safepoint_ability == NULL);
   The_Squeak_Interpreter()->distribute_initial_interpreter();
+  if (Micro_Benchmarks::run_instead_of_image)
+    Micro_Benchmarks::run_and_exit(); // before the timer, since the other cores wait for startInterpretingMessage all along
+  if (Synthetic_Heap::is_requested())
+    Synthetic_Heap::build_collect_and_exit(); // likewise
   Message_Statics::run_timer = true;
   {
     Safepoint_Ability sa(true);
@@ -340,6 +370,10 @@ int main(int argc, char *argv[]) {
   char** orig_argv = new char*[argc + 1];
   for (int i = 0;  i <= argc;  ++i)  orig_argv[i] = argv[i];
   process_arguments(argc, argv);
+  if (Image_Benchmark::is_requested()) {
+    headless = 1;
+    Image_Benchmark::prepare(argc, argv);
+  }
 
   if (MakeByteCodeTrace) {
     BytecodeTraceFile = fopen("bytecode_trace", "w");
@@ -354,9 +388,15 @@ int main(int argc, char *argv[]) {
   initialize_interpreter_instances_selftest_and_interpreter_proxy(orig_argv);
   
   char image_path[PATH_MAX];
-  realpath(argv[1], image_path);
+  const bool minimal_image = argc < 2;
+  if (minimal_image)
+    Minimal_Image::write(image_path);
+  else
+    realpath(argv[1], image_path);
   
   read_image(image_path);
+  if (minimal_image)
+    unlink(image_path);
   
   extern char** environ;
   sqr_main(argc, argv, environ);
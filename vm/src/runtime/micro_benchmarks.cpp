@@ -0,0 +1,262 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+# include "headers.h"
+
+bool Micro_Benchmarks::run_instead_of_image = false;
+
+
+// What the batches work on, set up by run_and_exit from the loaded image.
+
+static volatile int     sink;        // keeps the compiler from dropping results
+static Object* volatile object_sink;
+
+static const int max_objects = 4096; // a power of two
+static int  object_count;            // a power of two too
+static Oop  objects[max_objects];    // spread over the heaps
+
+static const int max_pairs = 128;
+static int  pair_count, hit_count;
+static Oop  selectors[max_pairs], classes[max_pairs];
+static Method_Cache* method_cache;
+
+static const int max_at_oops = 64;
+static int  at_hit_count;
+static Oop  at_hits[max_at_oops];
+static At_Cache* at_cache;
+
+static GC_Oop_Stack* oop_stack;
+static Oop array_class;
+static int partner; // rank for message_round_trip
+
+
+static void method_cache_hit(int n) {
+  int s = 0;
+  for (int i = 0, j = 0;  i < n;  ++i, j = j + 1 == hit_count ? 0 : j + 1)
+    s += method_cache->at(selectors[j], classes[j]) != NULL;
+  sink = s;
+}
+
+// Classes are never selectors, so every probe misses.
+static void method_cache_miss(int n) {
+  int s = 0;
+  for (int i = 0, j = 0;  i < n;  ++i, j = j + 1 == pair_count ? 0 : j + 1)
+    s += method_cache->at(classes[j], classes[pair_count - 1 - j]) != NULL;
+  sink = s;
+}
+
+static void at_cache_hit(int n) {
+  int s = 0;
+  for (int i = 0, j = 0;  i < n;  ++i, j = j + 1 == at_hit_count ? 0 : j + 1)
+    s += at_cache->get_entry(at_hits[j], false)->matches(at_hits[j]);
+  sink = s;
+}
+
+static void at_cache_install(int n) {
+  for (int i = 0;  i < n;  ++i) {
+    Oop x = objects[i & (object_count - 1)];
+    at_cache->get_entry(x, false)->install(x, false);
+  }
+}
+
+static void allocate_array(int n) {
+  for (int i = 0;  i < n;  ++i)
+    object_sink = (Object*)array_class.as_object()->instantiateClass(4);
+}
+
+static void object_table_lookup(int n) {
+  for (int i = 0;  i < n;  ++i)
+    object_sink = (Object*)objects[(i * 1021) & (object_count - 1)].as_object();
+}
+
+// Deep enough to cross into a second chunk of the stack and back.
+static void gc_oop_stack_push_pop(int n) {
+  for (int i = 0;  i < n;  ++i)
+    oop_stack->push((Object*)objects[i & (object_count - 1)].as_object());
+  for (int i = 0;  i < n;  ++i)
+    object_sink = oop_stack->pop();
+}
+
+static void message_round_trip(int n) {
+  for (int i = 0;  i < n;  ++i)
+    SEND_THEN_WAIT_FOR_MESSAGE(microBenchmarkPingMessage_class(), partner, microBenchmarkPingResponse);
+}
+
+static void scheduler_mutex(int n) {
+  for (int i = 0;  i < n;  ++i) {
+    Scheduler_Mutex sm("microbenchmark");
+  }
+}
+
+static void safepoint(int n) {
+  for (int i = 0;  i < n;  ++i) {
+    Safepoint_for_moving_objects sf("microbenchmark");
+  }
+}
+
+
+void Micro_Benchmarks::contend_for_scheduler_mutex(int count) {
+  for (int i = 0;  i < count;  ++i) {
+    Scheduler_Mutex sm("microbenchmark partner");
+  }
+}
+
+
+static int compare_doubles(const void* a, const void* b) {
+  double x = *(const double*)a,  y = *(const double*)b;
+  return x < y  ?  -1  :  x > y  ?  1  :  0;
+}
+
+
+void Micro_Benchmarks::measure(const char* name, int ops_per_sample, batch_fn batch) {
+  double ns_per_op[samples];
+  batch(ops_per_sample); // warm up the caches and branch predictors
+  double total = 0;
+  for (int s = 0;  s < samples;  ++s) {
+    u_int64 start = monotonic_nsecs();
+    batch(ops_per_sample);
+    ns_per_op[s] = double(monotonic_nsecs() - start) / ops_per_sample;
+    total += ns_per_op[s];
+  }
+  qsort(ns_per_op, samples, sizeof(double), compare_doubles);
+  fprintf(stdout, "\t%-24s %10d %10.1f %10.1f %10.1f %10.1f %10.1f\n", name, ops_per_sample, total / samples,
+          ns_per_op[samples * 50 / 100], ns_per_op[samples * 90 / 100], ns_per_op[samples * 99 / 100], ns_per_op[samples - 1]);
+  fflush(stdout);
+}
+
+
+void Micro_Benchmarks::skip(const char* name, const char* why) {
+  fprintf(stdout, "\t%-24s skipped: %s\n", name, why);
+}
+
+
+static void collect_objects() {
+  Memory_System* const ms = The_Memory_System();
+  int seen = 0;
+  object_count = 0;
+  // every 7th object, so that the oops are not all in a row in the table
+  FOR_ALL_RANKS(r)
+    for (int m = 0;  m < Memory_System::max_num_mutabilities;  ++m)
+      FOR_EACH_OBJECT_IN_HEAP(ms->heaps[r][m], obj)
+        if (object_count < max_objects  &&  !obj->isFreeObject()  &&  seen++ % 7 == 0)
+          objects[object_count++] = obj->as_oop();
+  while (object_count & (object_count - 1))
+    --object_count;
+}
+
+
+// The special selectors crossed with the first classes of the collected objects;
+// keeps the pairs that survive in the cache at the front.
+static void fill_method_cache() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  static const int class_count = max_pairs / 32;
+  Oop some_classes[class_count];
+  int n = 0;
+  for (int i = 0;  i < object_count  &&  n < class_count;  ++i) {
+    Oop k = objects[i].fetchClass();
+    bool is_new = true;
+    for (int j = 0;  j < n;  ++j)
+      is_new = is_new  &&  some_classes[j] != k;
+    if (is_new)
+      some_classes[n++] = k;
+  }
+  method_cache = new Method_Cache();
+  method_cache->flush_method_cache();
+  pair_count = 0;
+  for (int k = 0;  k < n;  ++k)
+    for (int s = 0;  s < 32;  ++s) {
+      selectors[pair_count] = interp->specialSelector(s);
+      classes[pair_count] = some_classes[k];
+      method_cache->addNewMethod(selectors[pair_count], classes[pair_count], interp->roots.nilObj, 0, interp->roots.nilObj, NULL, false);
+      ++pair_count;
+    }
+  hit_count = 0;
+  for (int i = 0;  i < pair_count;  ++i)
+    if (method_cache->at(selectors[i], classes[i]) != NULL) {
+      Oop s = selectors[i], k = classes[i];
+      selectors[i] = selectors[hit_count];  classes[i] = classes[hit_count];
+      selectors[hit_count] = s;  classes[hit_count] = k;
+      ++hit_count;
+    }
+}
+
+
+static void fill_at_cache() {
+  at_cache = new At_Cache();
+  at_cache->flush_at_cache();
+  int n = min(object_count, max_at_oops);
+  for (int i = 0;  i < n;  ++i)
+    at_cache->get_entry(objects[i], false)->install(objects[i], false);
+  at_hit_count = 0;
+  for (int i = 0;  i < n;  ++i)
+    if (at_cache->get_entry(objects[i], false)->matches(objects[i]))
+      at_hits[at_hit_count++] = objects[i];
+}
+
+
+void Micro_Benchmarks::run_and_exit() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  Safepoint_Ability sa(true);
+  collect_objects();
+  fill_method_cache();
+  fill_at_cache();
+  oop_stack = new GC_Oop_Stack();
+  array_class = interp->splObj(Special_Indices::ClassArray);
+
+  fprintf(stdout, "Microbenchmarks on %d cores, ns per op over %d samples:\n",
+          Logical_Core::group_size, samples);
+  fprintf(stdout, "\t%-24s %10s %10s %10s %10s %10s %10s\n", "", "ops/sample", "mean", "p50", "p90", "p99", "max");
+
+  measure("method_cache_hit",    1000, method_cache_hit);
+  measure("method_cache_miss",   1000, method_cache_miss);
+  if (at_hit_count > 0)
+    measure("at_cache_hit",      1000, at_cache_hit);
+  else
+    skip("at_cache_hit", "no objects");
+  measure("at_cache_install",    1000, at_cache_install);
+  measure("object_table_lookup", 1000, object_table_lookup);
+  measure("gc_oop_stack_push_pop", 12000, gc_oop_stack_push_pop);
+
+  static const int ops_per_allocation_sample = 500;
+  Multicore_Object_Heap* h = The_Memory_System()->heaps[Logical_Core::my_rank()][Memory_System::read_write];
+  // an Array of 4 is well under 64 bytes with its headers; no GC is wanted while timing
+  if (h->sufficientSpaceToAllocate(2 * (samples + 1) * ops_per_allocation_sample * 64))
+    measure("allocate_array_of_4", ops_per_allocation_sample, allocate_array);
+  else
+    skip("allocate_array_of_4", "too little room in the heap");
+
+  if (Logical_Core::group_size > 1) {
+    FOR_ALL_OTHER_RANKS(r) {
+      partner = r;
+      char name[BUFSIZ];
+      snprintf(name, sizeof(name), "message_round_trip_%d", r);
+      measure(name, 10, message_round_trip);
+    }
+  }
+  else
+    skip("message_round_trip", "needs more than one core");
+
+  measure("scheduler_mutex", 1000, scheduler_mutex);
+  if (Logical_Core::group_size > 1) {
+    microBenchmarkContendMessage_class((samples + 1) * 1000).send_to_other_cores();
+    measure("scheduler_mutex_handoff", 1000, scheduler_mutex);
+  }
+  else
+    skip("scheduler_mutex_handoff", "needs more than one core");
+
+  measure("safepoint", 10, safepoint);
+
+  ioExit();
+}
+
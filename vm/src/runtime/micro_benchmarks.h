@@ -0,0 +1,39 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// Timings of the VM's hot paths, to catch regressions before they show up in whole benchmarks.
+// With -microbench, main runs them once the image is loaded and the interpreter distributed,
+// instead of starting the image's processes, prints them, and quits.
+// The other cores are then waiting for startInterpretingMessage, handling messages and
+// stopping for safepoints as they wait, so the message and safepoint timings see idle partners.
+// Each benchmark is timed in samples of a batch of operations; the ns per operation of the
+// samples give the mean and percentiles. Samples are timed with monotonic_nsecs, which works
+// without Count_Cycles.
+// make bench runs them at each of BENCH_CORES cores.
+
+class Micro_Benchmarks {
+public:
+  static bool run_instead_of_image; // -microbench
+  static const int samples = 200;
+
+  static void run_and_exit();
+  static void contend_for_scheduler_mutex(int count); // on the other cores, for scheduler_mutex_handoff
+
+private:
+  typedef void (*batch_fn)(int n);
+
+  static void measure(const char* name, int ops_per_sample, batch_fn batch);
+  static void skip(const char* name, const char* why);
+};
+
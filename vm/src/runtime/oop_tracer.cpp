@@ -20,7 +20,8 @@
 Oop Oop_Tracer::array_class() { return The_Squeak_Interpreter()->splObj(Special_Indices::ClassArray); }
 
 void Oop_Tracer::do_all_roots(Oop_Closure* oc) {
-  for (int i = 0;  i < end_of_live_data();  ++i)
-    oc->value(&((Oop*)buffer)[i], (Object_p)NULL);
+  for (int i = 0;  i < capacity();  ++i)
+    if (is_live(i))
+      oc->value(&((Oop*)buffer)[i], (Object_p)NULL);
 }
 
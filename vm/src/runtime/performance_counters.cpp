@@ -13,6 +13,7 @@
 # include "headers.h"
 
 
+bool Performance_Counters::enabled = Collect_Performance_Counters;
 Performance_Counters* Performance_Counters::_all_perf_counters[Max_Number_Of_Cores] = { NULL };
 
 Performance_Counters::Performance_Counters() {
@@ -30,16 +31,23 @@ Performance_Counters::Performance_Counters() {
   # undef INITIALIZE
 }
 
-# if Collect_Performance_Counters
-
 # define IMPL_STATIC_COUNTER_METHODS(name, type, initial_value) \
   void Performance_Counters::count_##name##_static() {\
-    The_Squeak_Interpreter()->perf_counter.count_##name(); \
+    PERF_CNT(The_Squeak_Interpreter(), count_##name()); \
   }
 
 # define IMPL_STATIC_ACCUMULATOR_METHODS(name, type, initial_value) \
   void Performance_Counters::add_##name##_static(type value) {\
-    The_Squeak_Interpreter()->perf_counter.add_##name(value); \
+    PERF_CNT(The_Squeak_Interpreter(), add_##name(value)); \
+  }
+
+# define IMPL_TOTALS(name, type, initial_value) \
+  type Performance_Counters::total_##name() { \
+    type sum = initial_value; \
+    FOR_ALL_RANKS(r) \
+      if (_all_perf_counters[r] != NULL) \
+        sum += _all_perf_counters[r]->name; \
+    return sum; \
   }
 
 
@@ -47,23 +55,26 @@ FOR_ALL_PERFORMANCE_COUNTERS_DO(IMPL_STATIC_COUNTER_METHODS)
 
 FOR_ALL_PERFORMANCE_ACCUMULATORS_DO(IMPL_STATIC_ACCUMULATOR_METHODS)
 
+FOR_ALL_PERFORMANCE_COUNTERS_DO(IMPL_TOTALS)
+FOR_ALL_PERFORMANCE_ACCUMULATORS_DO(IMPL_TOTALS)
+
 # undef IMPL_STATIC_COUNTER_METHODS
 # undef IMPL_STATIC_ACCUMULATOR_METHODS
-
-
-# endif // Collect_Performance_Counters
+# undef IMPL_TOTALS
 
 
 void Performance_Counters::print() {
-  if (!Collect_Performance_Counters)
+  if (!enabled)
     return;
   
   fprintf(stdout, "Performance Counters:\n");
   
   FOR_ALL_RANKS(r) {
+    if (_all_perf_counters[r] == NULL)
+      continue;
     fprintf(stdout, "\tRank %d:\n", r);
     
-    # define PRINT(name, type, initial_value) fprintf(stdout, "\t %-30s = %10d\n", #name, _all_perf_counters[r]->name);
+    # define PRINT(name, type, initial_value) fprintf(stdout, "\t %-30s = %10lld\n", #name, _all_perf_counters[r]->name);
 
     FOR_ALL_PERFORMANCE_COUNTERS_DO(PRINT)
     
@@ -80,18 +91,23 @@ void Performance_Counters::print() {
     
   }
 
+  fprintf(stdout, "\tAll ranks:\n");
+  # define PRINT(name, type, initial_value) fprintf(stdout, "\t %-30s = %10lld\n", #name, total_##name());
+  FOR_ALL_PERFORMANCE_COUNTERS_DO(PRINT)
+  # undef PRINT
+  fprintf(stdout, "\n");
 }
 
 void Performance_Counters::reset() {
-  if (!Collect_Performance_Counters)
-    return;
-  
   FOR_ALL_RANKS(r) {
+    if (_all_perf_counters[r] == NULL)
+      continue;
   
     # define RESET_ALL_COUNTERS(name, type, initial_value) \
       _all_perf_counters[r]->name = initial_value;
   
     FOR_ALL_PERFORMANCE_COUNTERS_DO(RESET_ALL_COUNTERS)
+    FOR_ALL_PERFORMANCE_ACCUMULATORS_DO(RESET_ALL_COUNTERS)
   
     # undef RESET_ALL_COUNTERS
   
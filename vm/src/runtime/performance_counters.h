@@ -10,37 +10,54 @@
  ******************************************************************************/
 
 
-# if Collect_Performance_Counters
-  // use like PERF_CNT(The_Squeak_Interpreter(), add_interpret_cycles(foo - start));
-  # define PERF_CNT(interp, counter_or_accumulator_call) interp->perf_counter.counter_or_accumulator_call
-  
-# else
-  # define PERF_CNT(interp, counter_or_accumulator_call)
+// Software event counts per core, always compiled in and counted only while
+// Performance_Counters::enabled: -perf_counters, or primitivePerformanceCounters.
+// It starts out as Collect_Performance_Counters.
+// Each core counts into its own interpreter's counters, padded to a cache line, with plain
+// (relaxed) increments; readers sum over the cores on demand and may see slightly stale counts.
 
-# endif  // Collect_Performance_Counters
+// use like PERF_CNT(The_Squeak_Interpreter(), add_interpret_cycles(foo - start));
+# define PERF_CNT(interp, counter_or_accumulator_call) \
+  if (!Performance_Counters::enabled) ; else interp->perf_counter.counter_or_accumulator_call
 
 
 
 class Performance_Counters {
+public:
+  static bool enabled; // threadsafe config value, read without synchronization
+
 private:
 
   static Performance_Counters* _all_perf_counters[Max_Number_Of_Cores];
   
   # define FOR_ALL_PERFORMANCE_COUNTERS_DO(template) \
-    template(acquire_safepoint,           int, 0) \
-    template(acquire_scheduler_mutex,     int, 0) \
-    template(send_intercore_messages,     int, 0) \
-    template(received_intercore_messages, int, 0) \
-    template(full_gc,                     int, 0) \
-    template(methods_executed,            int, 0) \
-    template(primitive_invokations,       int, 0) \
-    template(bytecodes_executed,          int, 0) \
+    template(acquire_safepoint,           u_int64, 0LL) \
+    template(acquire_scheduler_mutex,     u_int64, 0LL) \
+    template(send_intercore_messages,     u_int64, 0LL) \
+    template(received_intercore_messages, u_int64, 0LL) \
+    template(full_gc,                     u_int64, 0LL) \
+    template(methods_executed,            u_int64, 0LL) \
+    template(primitive_invokations,       u_int64, 0LL) \
+    template(bytecodes_executed,          u_int64, 0LL) \
+    \
+    /* Squeak_Interpreter::lookupInMethodCacheSel() */ \
+    template(method_cache_hits,           u_int64, 0LL) \
+    template(method_cache_misses,         u_int64, 0LL) \
+    \
+    /* Squeak_Interpreter::allocateOrRecycleContext() */ \
+    template(contexts_recycled,           u_int64, 0LL) \
+    template(contexts_allocated,          u_int64, 0LL) \
     \
     /* Stats from within Squeak_Interpreter::multicore_interrupt() */ \
-    template(multicore_interrupts,        int, 0) \
-    template(multicore_interrupt_check,   int, 0) \
-    template(yield_requested,             int, 0) \
-    template(data_available,              int, 0) \
+    template(multicore_interrupts,        u_int64, 0LL) \
+    template(multicore_interrupt_check,   u_int64, 0LL) \
+    template(yield_requested,             u_int64, 0LL) \
+    template(data_available,              u_int64, 0LL) \
+    \
+    /* Run_Queues, see Squeak_Interpreter::transfer_to_hinted_process() */ \
+    template(run_queue_hits,              u_int64, 0LL) \
+    template(run_queue_steals,            u_int64, 0LL) \
+    template(run_queue_stale_hints,       u_int64, 0LL) \
  
  
   # define FOR_ALL_PERFORMANCE_ACCUMULATORS_DO(template) \
@@ -67,8 +84,7 @@ public:
   
   Performance_Counters();
   
-# if Collect_Performance_Counters
-  
+  // Callers check enabled, see PERF_CNT; the _static ones check it themselves.
   # define DECLARE_COUNTER_METHODS(name, type, initial_value) \
     FORCE_INLINE void count_##name() { \
       /* Not necessary anymore OS_Interface::atomic_fetch_and_add(&name, 1); */ \
@@ -83,22 +99,7 @@ public:
     } \
     \
     static void add_##name##_static(type value);
-  
-# else
 
-  # define DECLARE_COUNTER_METHODS(name, type, initial_value) \
-    FORCE_INLINE void count_##name() const {} \
-    \
-    static FORCE_INLINE void count_##name##_static() {};
-  
-  # define DECLARE_ACCUMULATOR_METHODS(name, type, initial_value) \
-    FORCE_INLINE void add_##name(type) const {} \
-    \
-    static void add_##name##_static(type) {}
-
-# endif  
-
-  
   FOR_ALL_PERFORMANCE_COUNTERS_DO    (DECLARE_COUNTER_METHODS)
   FOR_ALL_PERFORMANCE_ACCUMULATORS_DO(DECLARE_ACCUMULATOR_METHODS)
   
@@ -119,6 +120,15 @@ public:
   
 
   
+  # define DECLARE_TOTALS(name, type, initial_value) \
+    static type total_##name();
+
+  FOR_ALL_PERFORMANCE_COUNTERS_DO    (DECLARE_TOTALS)
+  FOR_ALL_PERFORMANCE_ACCUMULATORS_DO(DECLARE_TOTALS)
+
+  # undef DECLARE_TOTALS
+
+
   static void print();
   static void reset();
   
@@ -131,4 +141,4 @@ public:
     # undef INITIALIZE
   }
   
-};
+} __attribute__((aligned(64))); // owned by one core
@@ -0,0 +1,53 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// One bit per priority (0-based), so that the highest non-empty one is found with a
+// leading_zeros per word instead of looking at each priority in turn.
+// Not synchronized: the user holds whatever lock guards the lists it mirrors.
+
+class Priority_Bitmap {
+public:
+  static const int max_priorities = 128; // Squeak uses 8 lists, Pharo 80
+
+private:
+  static const int bits_per_word = 32;
+  static const int word_count = max_priorities / bits_per_word;
+  u_int32 words[word_count];
+
+public:
+  void clear_all() {
+    for (int i = 0;  i < word_count;  ++i)
+      words[i] = 0;
+  }
+
+  bool is_set(int pri) const { return words[pri / bits_per_word]  &  (1u << (pri % bits_per_word)); }
+  void set(int pri)   { words[pri / bits_per_word] |=  (1u << (pri % bits_per_word)); }
+  void clear(int pri) { words[pri / bits_per_word] &= ~(1u << (pri % bits_per_word)); }
+
+  // answers -1 if there is none
+  int highest_at_or_below(int pri) const {
+    if (pri < 0)  return -1;
+    if (pri >= max_priorities)  pri = max_priorities - 1;
+    for (int w = pri / bits_per_word;  w >= 0;  --w) {
+      u_int32 bits = words[w];
+      if (w == pri / bits_per_word  &&  pri % bits_per_word != bits_per_word - 1)
+        bits &= (1u << (pri % bits_per_word + 1)) - 1;
+      if (bits)
+        return w * bits_per_word  +  bits_per_word - 1 - OS_Interface::leading_zeros(bits);
+    }
+    return -1;
+  }
+  int highest() const { return highest_at_or_below(max_priorities - 1); }
+};
+
@@ -0,0 +1,294 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+#include "headers.h"
+
+bool Run_Queues::use_run_queues = true;
+u_int64 Run_Queues::affinity_delay_nsecs = 30000;
+
+
+Run_Queues* Run_Queues::create() {
+  Run_Queues* rq = (Run_Queues*)Memory_Semantics::shared_calloc(1, sizeof(Run_Queues));
+  for (int rank = 0;  rank < Max_Number_Of_Cores;  ++rank)
+    rq->queues[rank].highest = -1;
+  for (int i = 0;  i < affinity_table_size;  ++i)
+    rq->affinities[i].last_rank = rq->affinities[i].preferred_rank = -1;
+  return rq;
+}
+
+
+// priority is 1-based, like the Process field
+void Run_Queues::push(int rank, Oop proc, int priority) {
+  int pri = priority - 1;
+  if (pri < 0  ||  pri >= max_priorities) {
+    note_dropped_hint();
+    return;
+  }
+  Core_Queue* q = &queues[rank];
+  lock(q);
+  if (q->count[pri] == slots_per_priority) {
+    // forget the oldest; the lists still have it
+    q->first[pri] = (q->first[pri] + 1) % slots_per_priority;
+    --q->count[pri];
+    note_dropped_hint();
+  }
+  int slot = (q->first[pri] + q->count[pri]) % slots_per_priority;
+  q->procs[pri][slot] = proc;
+  q->pushed_at[pri][slot] = monotonic_nsecs();
+  ++q->count[pri];
+  q->nonempty.set(pri);
+  if (pri > q->highest)  q->highest = pri;
+  unlock(q);
+  // Wake the core it is for; or, if that one is busy, some idle core, which will steal it
+  // once it is old enough (see nsecs_till_a_hint_ripens), should the owner still be busy then.
+  if (rank != Logical_Core::my_rank()  &&  logical_cores[rank].is_parked())
+    logical_cores[rank].unpark();
+  else
+    Logical_Core::unpark_one_other_than(rank);
+}
+
+
+// Drops the stale hints it meets on the way, under the queue's lock only, so that
+// the taker need take the Scheduler_Mutex just once, to unlink the process it gets.
+bool Run_Queues::take_from(int rank, int pri, Oop& proc) {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  Core_Queue* q = &queues[rank];
+  lock(q);
+  bool r = false;
+  while (!r  &&  q->highest == pri  &&  q->count[pri] > 0) {
+    proc = q->procs[pri][q->first[pri]];
+    q->first[pri] = (q->first[pri] + 1) % slots_per_priority;
+    if (--q->count[pri] == 0) {
+      q->nonempty.clear(pri);
+      q->highest = q->nonempty.highest_at_or_below(pri - 1);
+    }
+    r = interp->is_hinted_process_still_runnable(proc);
+  }
+  unlock(q);
+  return r;
+}
+
+
+// Has the oldest hint at pri waited long enough on its core to be stolen?
+bool Run_Queues::is_ripe_for_stealing(int rank, int pri, u_int64 now) {
+  Core_Queue* q = &queues[rank];
+  return now - q->pushed_at[pri][q->first[pri]]  >=  affinity_delay_nsecs;
+}
+
+
+// Take the oldest hint of the highest priority on any core, preferring this core's own,
+// and leaving young ones to their cores.
+// The peeks are racy; take_from rechecks under the lock.
+bool Run_Queues::take(int rank, Oop& proc) {
+  for (;;) {
+    u_int64 now = monotonic_nsecs();
+    int best_rank = rank,  best_pri = queues[rank].highest;
+    FOR_ALL_RANKS(r) {
+      int pri = queues[r].highest;
+      if (pri > best_pri  &&  is_ripe_for_stealing(r, pri, now)) {
+        best_pri = pri;
+        best_rank = r;
+      }
+    }
+    if (best_pri < 0)
+      return false;
+    if (take_from(best_rank, best_pri, proc)) {
+      if (best_rank != rank)
+        PERF_CNT(The_Squeak_Interpreter(), count_run_queue_steals());
+      return true;
+    }
+  }
+}
+
+
+// Only into the open slot of a parked core, which will look there first when woken.
+// Once the core has closed its slot, it is busy, or is about to look for work anyway.
+bool Run_Queues::hand_off(int rank, Oop proc) {
+  if (!OS_Interface::atomic_compare_and_swap(&handoffs[rank].proc_bits, Handoff_Slot::open, proc.bits()))
+    return false;
+  logical_cores[rank].unpark();
+  return true;
+}
+
+
+// By the parked core, when it wakes; a process handed off till then stays for take_handoff.
+void Run_Queues::close_handoff_slot(int rank) {
+  OS_Interface::atomic_compare_and_swap(&handoffs[rank].proc_bits, Handoff_Slot::open, Handoff_Slot::closed);
+}
+
+
+bool Run_Queues::take_handoff(int rank, Oop& proc) {
+  if (!has_handoff(rank))
+    return false;
+  // only this core empties a full slot
+  proc = Oop::from_bits(handoffs[rank].proc_bits);
+  handoffs[rank].proc_bits = Handoff_Slot::closed;
+  ++handoffs_taken[rank];
+  return true;
+}
+
+
+void Run_Queues::drop_hints_of(int rank) {
+  if (has_handoff(rank)) {
+    handoffs[rank].proc_bits = Handoff_Slot::closed;
+    note_dropped_hint();
+  }
+  Core_Queue* q = &queues[rank];
+  lock(q);
+  if (q->highest >= 0) {
+    for (int pri = 0;  pri <= q->highest;  ++pri)
+      q->first[pri] = q->count[pri] = 0;
+    q->nonempty.clear_all();
+    q->highest = -1;
+    note_dropped_hint();
+  }
+  unlock(q);
+}
+
+
+// How long till a hint on some other core is old enough to steal: 0 if one already is,
+// ~0 if there are none. A parked core sleeps no longer than this.
+u_int64 Run_Queues::nsecs_till_a_hint_ripens(int rank) {
+  u_int64 now = monotonic_nsecs();
+  u_int64 r = ~0ULL;
+  FOR_ALL_RANKS(other) {
+    int pri = queues[other].highest;
+    if (other == rank  ||  pri < 0)
+      continue;
+    u_int64 age = now - queues[other].pushed_at[pri][queues[other].first[pri]];
+    r = min(r, age >= affinity_delay_nsecs  ?  0  :  affinity_delay_nsecs - age);
+  }
+  return r;
+}
+
+
+// At the end of a GC, with everyone at the safepoint: hinted processes may have died or moved.
+void Run_Queues::forget_all_hints() {
+  FOR_ALL_RANKS(r)
+    drop_hints_of(r);
+}
+
+
+// Also at the end of a GC, after the sweep has freed the dead objects' table entries.
+void Run_Queues::forget_dead_processes() {
+  for (int i = 0;  i < affinity_table_size;  ++i) {
+    Affinity* a = &affinities[i];
+    if (a->proc.bits() == 0)
+      continue;
+    if (Use_Object_Table  &&  !The_Memory_System()->object_table->is_OTE_free(a->proc))
+      continue;
+    a->proc = Oop::from_bits(0);
+    a->last_rank = a->preferred_rank = -1;
+    a->runnable_at = 0;
+  }
+}
+
+
+bool Run_Queues::might_have_a_hint_for(int rank) {
+  if (queues[rank].highest >= 0  ||  has_handoff(rank))
+    return true;
+  u_int64 now = monotonic_nsecs();
+  FOR_ALL_RANKS(r) {
+    int pri = queues[r].highest;
+    if (pri >= 0  &&  is_ripe_for_stealing(r, pri, now))
+      return true;
+  }
+  return false;
+}
+
+
+// The table is only changed under the Scheduler_Mutex; readers may see a stale entry.
+Run_Queues::Affinity* Run_Queues::affinity_of(Object_p proc_obj, bool claim) {
+  Affinity* a = &affinities[proc_obj->hashBits() % affinity_table_size];
+  if (a->proc == proc_obj->as_oop())
+    return a;
+  if (!claim)
+    return NULL;
+  a->proc = proc_obj->as_oop();
+  a->last_rank = a->preferred_rank = -1;
+  a->runnable_at = 0;
+  return a;
+}
+
+
+int Run_Queues::home_rank_of(Object_p proc_obj, int default_rank) {
+  Affinity* a = affinity_of(proc_obj, false);
+  if (a == NULL)                  return default_rank;
+  if (a->preferred_rank >= 0)     return a->preferred_rank;
+  if (a->last_rank >= 0)          return a->last_rank;
+  return default_rank;
+}
+
+
+void Run_Queues::note_runnable(Object_p proc_obj) {
+  affinity_of(proc_obj, true)->runnable_at = monotonic_nsecs();
+}
+
+
+void Run_Queues::note_running_on(Object_p proc_obj, int rank) {
+  Affinity* a = affinity_of(proc_obj, true);
+  if (a->last_rank == rank)
+    ++affine_resumes[rank];
+  else if (a->last_rank >= 0) {
+    ++migrations[rank];
+    if (a->runnable_at != 0) {
+      u_int64 nsecs = monotonic_nsecs() - a->runnable_at;
+      migration_nsecs[rank] += nsecs;
+      if (nsecs > max_migration_nsecs[rank])  max_migration_nsecs[rank] = nsecs;
+    }
+  }
+  a->last_rank = rank;
+  a->runnable_at = 0;
+}
+
+
+void Run_Queues::set_preferred_rank(Object_p proc_obj, int rank) {
+  affinity_of(proc_obj, true)->preferred_rank = rank;
+}
+
+
+int Run_Queues::total_migrations() {
+  int sum = 0;
+  FOR_ALL_RANKS(r)  sum += migrations[r];
+  return sum;
+}
+
+
+int Run_Queues::total_affine_resumes() {
+  int sum = 0;
+  FOR_ALL_RANKS(r)  sum += affine_resumes[r];
+  return sum;
+}
+
+
+int Run_Queues::total_handoffs() {
+  int sum = 0;
+  FOR_ALL_RANKS(r)  sum += handoffs_taken[r];
+  return sum;
+}
+
+
+u_int64 Run_Queues::total_migration_nsecs() {
+  u_int64 sum = 0;
+  FOR_ALL_RANKS(r)  sum += migration_nsecs[r];
+  return sum;
+}
+
+
+u_int64 Run_Queues::max_migration_nsecs_of_all() {
+  u_int64 m = 0;
+  FOR_ALL_RANKS(r)  m = max(m, max_migration_nsecs[r]);
+  return m;
+}
+
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// Per-core queues of processes that the VM has just made runnable, by priority.
+// The ProcessorScheduler lists in the heap stay the truth, and are only changed under
+// the Scheduler_Mutex as before; these are hints, so that an idle core can pick a process
+// without taking that mutex to walk every list.
+// A core pushes onto its own queue; an idle core takes the highest priority hint it
+// can find, from its own queue if that is as good as any, else by stealing from another core's.
+// A hint may be stale by the time it is taken: take drops those it can tell are stale under
+// the queue's lock, and the taker checks the one it gets again under the Scheduler_Mutex,
+// which it takes only to unlink the process. -- see Squeak_Interpreter::transfer_to_hinted_process
+// Hints hold Oops that GC does not trace, so the collector drops every core's hints while it
+// still holds the safepoint, before any freed object table entry can be reused. -- see forget_all_hints
+//
+// Affinity: a hint goes to the queue of the core the process would rather run on (set by
+// primitiveSetProcessSoftAffinity), else of the core it last ran on, whose caches and
+// read-write heap hold its objects. Other cores leave it there for affinity_delay_nsecs
+// before stealing it.
+//
+// Handoff: if that core is parked, the hint instead goes into its handoff slot with one CAS,
+// and the core takes it first when it wakes; all that moves is the process Oop, and the core
+// starts the process from its suspended context, as for any hint. Only one process fits,
+// and no other core can steal it, which is fine since the owner is idle.
+// A migration's latency runs from when the process was made runnable till another core starts it.
+
+class Run_Queues {
+public:
+  static bool use_run_queues; // threadsafe readonly config value
+  static u_int64 affinity_delay_nsecs; // threadsafe readonly config value; times are monotonic_nsecs, which need no Count_Cycles
+
+  static const int max_priorities = Priority_Bitmap::max_priorities;
+  static const int slots_per_priority = 8;
+
+private:
+  struct Core_Queue {
+    int lock;
+    int highest; // no hints above this priority index, -1 if empty; peeked at without the lock
+    Priority_Bitmap nonempty;
+    int first[max_priorities];
+    int count[max_priorities];
+    Oop procs[max_priorities][slots_per_priority];
+    u_int64 pushed_at[max_priorities][slots_per_priority];
+  };
+  Core_Queue queues[Max_Number_Of_Cores];
+
+  // By identity hash; a process that shares its hash with another may lose its affinity.
+  // The Oops are not traced: after each GC, forget_dead_processes clears the entries of
+  // processes that died, so that an object table entry reused later inherits nothing.
+  // Without an object table, a GC may move any process, so it clears them all.
+  static const int affinity_table_size = 1 << 12; // see Object::hashBits
+  struct Affinity {
+    Oop proc;
+    int16 last_rank;      // -1 if unknown
+    int16 preferred_rank; // -1 if none
+    u_int64 runnable_at;  // when last hinted, 0 if not since it ran
+  };
+  Affinity affinities[affinity_table_size];
+
+  // Only a parked core opens its slot, and only it closes it again, so a process handed off
+  // into an open slot is sure to be taken. Process Oops are never SmallIntegers, so never open.
+  struct Handoff_Slot {
+    static const oop_int_t closed = 0;
+    static const oop_int_t open   = 1;
+    oop_int_t proc_bits; // or closed, or open
+  } __attribute__((aligned(64)));
+  Handoff_Slot handoffs[Max_Number_Of_Cores];
+
+  int migrations[Max_Number_Of_Cores];     // resumed on another core than the last one
+  int affine_resumes[Max_Number_Of_Cores]; // resumed on the same one
+  int handoffs_taken[Max_Number_Of_Cores];
+  u_int64 migration_nsecs[Max_Number_Of_Cores];
+  u_int64 max_migration_nsecs[Max_Number_Of_Cores];
+
+  // Bumped whenever a runnable process goes unhinted (full queue, hints dropped),
+  // so that idle cores know they must walk the lists to find it.
+  int dropped_hints_epoch;
+
+  void lock(Core_Queue* q) {
+    while (!OS_Interface::atomic_compare_and_swap(&q->lock, 0, 1))
+      ;
+  }
+  void unlock(Core_Queue* q) {
+    OS_Interface::mem_fence();
+    q->lock = 0;
+  }
+  bool take_from(int rank, int pri, Oop& proc);
+  bool is_ripe_for_stealing(int rank, int pri, u_int64 now);
+  Affinity* affinity_of(Object_p proc_obj, bool claim);
+
+public:
+  static Run_Queues* create();
+
+  void push(int rank, Oop proc, int priority);
+  bool take(int rank, Oop& proc);
+  void drop_hints_of(int rank);
+  void forget_all_hints();
+  void forget_dead_processes();
+
+  bool hand_off(int rank, Oop proc);
+  bool take_handoff(int rank, Oop& proc);
+  void open_handoff_slot(int rank) { handoffs[rank].proc_bits = Handoff_Slot::open; }
+  void close_handoff_slot(int rank);
+  bool has_handoff(int rank) {
+    oop_int_t bits = handoffs[rank].proc_bits;
+    return bits != Handoff_Slot::closed  &&  bits != Handoff_Slot::open;
+  }
+  bool has_hint_above(int rank, int priority) { return queues[rank].highest > priority; }
+
+  bool might_have_a_hint_for(int rank);
+  u_int64 nsecs_till_a_hint_ripens(int rank);
+  int  get_dropped_hints_epoch() { return dropped_hints_epoch; }
+  void note_dropped_hint() { OS_Interface::atomic_fetch_and_add(&dropped_hints_epoch, 1); }
+
+  int  home_rank_of(Object_p proc_obj, int default_rank);
+  void note_runnable(Object_p proc_obj);
+  void note_running_on(Object_p proc_obj, int rank);
+  void set_preferred_rank(Object_p proc_obj, int rank);
+  int  total_migrations();
+  int  total_affine_resumes();
+  int  total_handoffs();
+  u_int64 total_migration_nsecs();
+  u_int64 max_migration_nsecs_of_all();
+};
+
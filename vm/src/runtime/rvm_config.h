@@ -122,6 +122,8 @@
   template(Extra_Preheader_Word_Experiment) \
   template(Use_BufferedChannelDebug) \
   template(Use_PerSender_Message_Queue) \
+  template(Use_Message_Ring) \
+  template(Message_Ring_Bytes) \
   template(Include_Closure_Support) \
   template(Hammer_Safepoints) /* for debugging */ \
   \
@@ -426,10 +428,19 @@
 # define Use_BufferedChannelDebug 1
 # endif
 
+# ifndef Use_Message_Ring
+// One MessageRing per receiver, written by all senders, in a Shared_Memory_Message_Queue
+# define Use_Message_Ring (!On_Tilera)
+# endif
+
+# ifndef Message_Ring_Bytes
+# define Message_Ring_Bytes (1 << 18)  /* per receiver, must be a power of two */
+# endif
+
 # ifndef Use_PerSender_Message_Queue
 // This will use Shared_Memory_Queue_Per_Sender class
-// It is the new default.
-# define Use_PerSender_Message_Queue 1
+// It was the default before the MessageRing.
+# define Use_PerSender_Message_Queue (!Use_Message_Ring)
 # endif
 
 # ifndef Include_Closure_Support
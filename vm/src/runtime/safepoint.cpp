@@ -15,6 +15,9 @@
 #include "headers.h"
 
 
+bool Safepoint_Tracker::use_shared_memory = true;
+
+
 OS_Mutex_Interface* Safepoint_Actions::get_mutex() {
   return The_Squeak_Interpreter()->get_safepoint_mutex();
 }
@@ -56,15 +59,32 @@ void Safepoint_Tracker::request_other_cores_to_safepoint(const char* why) {
   assert_always(_am_requesting_other_cores_to_safepoint >= 0);
   ++_am_requesting_other_cores_to_safepoint;
   acquisition_timer.start();
+  u_int64 start = monotonic_nsecs();
+  Timeline* const timeline = The_Squeak_Interpreter()->timeline;
+  if (timeline != NULL)
+    timeline->begin(Timeline::safepoint, "request safepoint", why);
   
-  requestSafepointOnOtherCoresMessage_class(why).handle_here_or_send_to(Logical_Core::main_rank);
+  if (epochs != NULL)
+    request_through_shared_memory(why);
+  else {
+    requestSafepointOnOtherCoresMessage_class(why).handle_here_or_send_to(Logical_Core::main_rank);
   
-  do {
-    // xxxxxx Would things work and be more efficient with true instead false below? -- dmu 4/09
-    Message_Statics::process_any_incoming_messages(false);
-  } while (!is_every_other_core_safe());
+    do {
+      // xxxxxx Would things work and be more efficient with true instead false below? -- dmu 4/09
+      Message_Statics::process_any_incoming_messages(false);
+    } while (!is_every_other_core_safe());
+  }
   
   acquisition_timer.stop();
+  _acquired_at = monotonic_nsecs();
+  _acquired_why = why;
+  Safepoint_Stats* stats = The_Squeak_Interpreter()->safepoint_stats;
+  if (stats != NULL)
+    stats->record_acquisition(why, _acquired_at - start, _last_core_to_arrive);
+  if (timeline != NULL) {
+    timeline->end(Timeline::safepoint, "request safepoint");
+    timeline->begin(Timeline::safepoint, "hold safepoint", why);
+  }
   --_am_requesting_other_cores_to_safepoint;
   assert_always(_am_requesting_other_cores_to_safepoint >= 0);
   print_msg_for_request_safepoint("got safepoint", why);
@@ -72,8 +92,17 @@ void Safepoint_Tracker::request_other_cores_to_safepoint(const char* why) {
 
 
 void Safepoint_Tracker::release_other_cores_from_safepoint(const char* why) {
+  // still holding it, so no other core writes the stats
+  Safepoint_Stats* stats = The_Squeak_Interpreter()->safepoint_stats;
+  if (stats != NULL)
+    stats->record_release(_acquired_why, monotonic_nsecs() - _acquired_at);
+  if (The_Squeak_Interpreter()->timeline != NULL)
+    The_Squeak_Interpreter()->timeline->end(Timeline::safepoint, "hold safepoint");
   every_other_core_no_longer_safe();
-  releaseOtherCoresFromSafepointMessage_class().handle_here_or_send_to(Logical_Core::main_rank);
+  if (epochs != NULL)
+    release_through_shared_memory();
+  else
+    releaseOtherCoresFromSafepointMessage_class().handle_here_or_send_to(Logical_Core::main_rank);
   if (verbose)
     lprintf("relinquishing safepoint %s, depth %d\n",
             why, spin_depth());
@@ -86,6 +115,13 @@ void Safepoint_Tracker::spin_if_safepoint_requested_with_arguments(const char* f
   if (!Safepoint_Ability::is_interpreter_able())
     return;
 
+  if (epochs != NULL) {
+    // if spinning, the spin loop acks for us
+    if (!am_spinning()  &&  is_shared_memory_safepoint_requested())
+      stop_at_shared_memory_safepoint();
+    return;
+  }
+
   // need !is_spinning because otherwise will spin waiting for response
   // message to I am spinning message
   if (does_another_core_need_me_to_spin()  &&  !am_spinning()) {
@@ -125,6 +161,7 @@ void Safepoint_Tracker::spin_in_safepoint(const char* /* fn */, const char* /* f
 
   Timeout_Timer tt("spinning in safepoint", 60, Logical_Core::main_rank);
   tt.start();
+  Timeline_Slice ts(Timeline::safepoint, "at safepoint", _why_another_core_needs_me_to_spin);
 
   tell_core_I_am_spinning(_seq_no_of_another_needs_me_to_spin, false);
   while (does_another_core_need_me_to_spin())
@@ -138,6 +175,123 @@ void Safepoint_Tracker::tell_core_I_am_spinning(int seq_no_of_request, bool was_
 }
 
 
+
+Safepoint_Epochs* Safepoint_Epochs::create() {
+  Safepoint_Epochs* e = (Safepoint_Epochs*)Memory_Semantics::shared_calloc(1, sizeof(Safepoint_Epochs));
+  e->holder.value = none;
+  e->why = "";
+  return e;
+}
+
+
+void Safepoint_Tracker::request_through_shared_memory(const char* why) {
+  const int me = Logical_Core::my_rank();
+
+  // If another core has it or is getting it, stop for it like any other core, then try again.
+  while (!OS_Interface::atomic_compare_and_swap(&epochs->holder.value, Safepoint_Epochs::none, me)) {
+    if (am_spinning())
+      acknowledge_latest_request(); // already stopped, in a message handler; see spin loop
+    else
+      spin_if_safepoint_requested();
+    Message_Statics::process_any_incoming_messages(false);
+  }
+
+  // Only the holder writes requested, and the ack of the holder needs no waiting.
+  const int epoch = epochs->requested.value + 1;
+  epochs->why = why;
+  epochs->acks[me].value = epoch;
+  OS_Interface::mem_fence();
+  epochs->requested.value = epoch;
+  wake_other_cores();
+
+  // Keep handling messages: a core may need an answer from me before it reaches a check point.
+  int last_to_arrive = -1;
+  while (!has_every_other_core_acknowledged(epoch, last_to_arrive))
+    Message_Statics::process_any_incoming_messages(false);
+  OS_Interface::mem_fence();
+  every_other_core_is_safe(epoch, last_to_arrive);
+}
+
+
+void Safepoint_Tracker::release_through_shared_memory() {
+  assert_always_eq(epochs->holder.value, Logical_Core::my_rank());
+  OS_Interface::mem_fence();
+  epochs->released.value = epochs->requested.value;
+  epochs->why = "";
+  OS_Interface::mem_fence();
+  epochs->holder.value = Safepoint_Epochs::none;
+  wake_other_cores();
+}
+
+
+// Sets laggard to a core that has not, if any
+bool Safepoint_Tracker::has_every_other_core_acknowledged(int epoch, int& laggard) {
+  FOR_ALL_OTHER_RANKS(r)
+    if (epochs->acks[r].value < epoch) {
+      laggard = r;
+      return false;
+    }
+  return true;
+}
+
+
+// Fences pair up with the ones in park, see Logical_Core::unpark
+void Safepoint_Tracker::wake_other_cores() {
+  OS_Interface::mem_fence();
+  FOR_ALL_OTHER_RANKS(r)
+    logical_cores[r].unpark();
+}
+
+
+// While stopped, a core may see a later request from the next holder; it is still stopped, so ack that too,
+// else a core that asks for a safepoint from within a message handler while spinning would wait forever.
+void Safepoint_Tracker::acknowledge_latest_request() {
+  int* ack = &epochs->acks[Logical_Core::my_rank()].value;
+  if (epochs->requested.value > *ack) {
+    *ack = epochs->requested.value;
+    OS_Interface::mem_fence();
+  }
+}
+
+
+void Safepoint_Tracker::stop_at_shared_memory_safepoint() {
+  assert(_spin_depth == 0);
+  ++_spin_depth;
+  Logical_Core* const me = Logical_Core::my_core();
+  int* const ack = &epochs->acks[me->rank()].value;
+
+  _does_another_core_need_me_to_spin = true;
+  _which_other_core_needs_me_to_spin = epochs->holder.value;
+  _why_another_core_needs_me_to_spin = epochs->why;
+
+  Timeout_Timer tt("spinning in safepoint", 60, Logical_Core::main_rank);
+  tt.start();
+  Timeline_Slice ts(Timeline::safepoint, "at safepoint", _why_another_core_needs_me_to_spin);
+
+  for (;;) {
+    acknowledge_latest_request();
+    // the holder may ask me for roots, etc.
+    Message_Statics::process_any_incoming_messages(false);
+    if (epochs->released.value >= *ack)
+      break;
+
+    me->announce_parking();
+    if (   epochs->released.value >= *ack
+        || epochs->requested.value > *ack
+        || Message_Queue::are_data_available(me))
+      me->stop_parking();
+    else
+      me->park(10000); // the timeout lets the timer above go off
+  }
+  OS_Interface::mem_fence();
+
+  _does_another_core_need_me_to_spin = false;
+  _which_other_core_needs_me_to_spin = -1;
+  _why_another_core_needs_me_to_spin = "";
+  --_spin_depth;
+}
+
+
 void Safepoint_Tracker::self_destruct_all() {
   FOR_ALL_OTHER_RANKS(r)  {
     lprintf( "sending destruct to  %d\n", r);
@@ -194,6 +348,7 @@ void Safepoint_Master_Control::a_core_is_now_safe(int r, int seq_no, bool was_sp
   spin_request_timers[r]->stop();
   
   spinners.add(r);
+  last_core_to_become_safe = r;
   
   spinners_sequence_numbers[r] = prior_outstanding_spin_requests_sequence_numbers[r]; outstanding_spin_requests_sequence_numbers[r] = -1; 
   
@@ -332,7 +487,7 @@ void Safepoint_Master_Control::grant_safepoint_to_next_asker() {
     lprintf("Interactions::grant_safepoint_to(%d), seq_no(%d)\n",
             core_holding_global_safepoint, current_safepoint_sequence_number);
   
-  grantSafepointMessage_class(current_safepoint_sequence_number).handle_here_or_send_to(core_holding_global_safepoint);
+  grantSafepointMessage_class(current_safepoint_sequence_number, last_core_to_become_safe).handle_here_or_send_to(core_holding_global_safepoint);
 }
 
 
@@ -31,26 +31,62 @@ class Safepoint_Actions {
 Define_RVM_Mutex(Safepoint_for_moving_objects, Safepoint_Actions,17,18)
 
 
+// Shared-memory safepoints, for threads:
+// The requester takes holder by CAS, bumps requested, and waits till every other core's ack
+// has caught up. The other cores see requested move at the same check points where they
+// used to get requestCoreToSpinMessage, ack it, and park (still handling messages, for the GC)
+// till released catches up with their ack. The requester wakes them when it is done.
+// Replaces the message round trips through Safepoint_Master_Control on main,
+// whose cost grew with the number of cores; processes still use those. -- see use_shared_memory
+// Each word on its own cache line, since every core polls requested and released.
+
+class Safepoint_Epochs {
+public:
+  static const int none = -1;
+
+  struct Padded_Int {
+    int  value;
+    char _pad[64 - sizeof(int)];
+  };
+  Padded_Int holder;     // rank holding or acquiring the safepoint, or none
+  Padded_Int requested;  // epoch of the latest request
+  Padded_Int released;   // epoch of the latest release
+  Padded_Int acks[Max_Number_Of_Cores]; // latest epoch each core has stopped for
+  const char* why;       // of the holder, for debugging
+
+  static Safepoint_Epochs* create();
+};
+
+
 class Safepoint_Tracker {
   int    _spin_depth;
   bool  _is_every_other_core_safe;
   int   _sequence_number_of_last_granted_safepoint;
+  int   _last_core_to_arrive; // -1 if unknown
   bool  _does_another_core_need_me_to_spin;
   int   _which_other_core_needs_me_to_spin;
   int   _seq_no_of_another_needs_me_to_spin; 
   const char* _why_another_core_needs_me_to_spin;
   int   _am_requesting_other_cores_to_safepoint;
+  Safepoint_Epochs* epochs; // NULL when using the message protocol
+  u_int64     _acquired_at;  // for Safepoint_Stats
+  const char* _acquired_why;
 
   public:
   Safepoint_Acquisition_Timer acquisition_timer;
   static const bool verbose = false;
+  static bool use_shared_memory; // threadsafe readonly config value
 
 
  public:
-  Safepoint_Tracker() : acquisition_timer() {
+  Safepoint_Tracker(Safepoint_Epochs* e) : acquisition_timer() {
+    epochs = e;
+    _acquired_at = 0;
+    _acquired_why = "";
     _spin_depth = 0;
     _is_every_other_core_safe = false;
     _sequence_number_of_last_granted_safepoint = 0;
+    _last_core_to_arrive = -1;
     _does_another_core_need_me_to_spin = false;
     _which_other_core_needs_me_to_spin = -1;
     _seq_no_of_another_needs_me_to_spin = -1;
@@ -60,16 +96,23 @@ class Safepoint_Tracker {
   }
 
   void request_other_cores_to_safepoint(const char*);
+
+  // Has another core asked for a shared-memory safepoint this core has not stopped for yet?
+  // Only reads; cheap enough for check_for_multicore_interrupt, which runs at every bytecode.
+  bool is_shared_memory_safepoint_requested() {
+    return epochs != NULL  &&  epochs->requested.value > epochs->acks[Logical_Core::my_rank()].value;
+  }
 # define spin_if_safepoint_requested() spin_if_safepoint_requested_with_arguments(__FUNCTION__, __FILE__, __LINE__ )
   void spin_if_safepoint_requested_with_arguments(const char*, const char*, int);
 
   void release_other_cores_from_safepoint(const char*);
 
   bool is_every_other_core_safe() { return _is_every_other_core_safe; }
-  void every_other_core_is_safe(int seq_no)  {
+  void every_other_core_is_safe(int seq_no, int last_to_arrive)  {
     if (verbose) lprintf("every_other_core_is_safe()\n");
     _is_every_other_core_safe = true;
     _sequence_number_of_last_granted_safepoint = seq_no;
+    _last_core_to_arrive = last_to_arrive;
     
     Performance_Counters::count_acquire_safepoint_static();
   }
@@ -99,6 +142,12 @@ class Safepoint_Tracker {
 
   private:
   void spin_in_safepoint(const char*, const char*, int);
+  void request_through_shared_memory(const char*);
+  void release_through_shared_memory();
+  void stop_at_shared_memory_safepoint();
+  void acknowledge_latest_request();
+  bool has_every_other_core_acknowledged(int, int&);
+  void wake_other_cores();
   void tell_core_I_am_spinning(int seq_no_of_request, bool was_spinning);
   void print_msg_for_request_safepoint(const char* msg, const char* why);
 
@@ -113,6 +162,7 @@ class Safepoint_Master_Control {
   Rank_Set all_cores;
   static const int none = -1;
   int     core_holding_global_safepoint;
+  int     last_core_to_become_safe; // for Safepoint_Stats
   static int request_depth; // top-level request recursion, threadsafe?: not critical, does no have a functional purpose, Stefan 2009-09-06
   int step_recurse_level; // redundant with request_depth
   
@@ -133,6 +183,7 @@ public:
     cores_asking_for_a_global_safepoint(Max_Number_Of_Cores),
     outstanding_spin_requests(), spinners(), all_cores() {
     core_holding_global_safepoint = none;
+    last_core_to_become_safe = none;
     all_cores = Rank_Set::all_up_to(Logical_Core::group_size);
     FOR_ALL_RANKS(r)
       spin_request_timers[r] = new Timeout_Timer("spin request", 45 /* shorter than default */, r);
@@ -0,0 +1,160 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+#include "headers.h"
+
+bool Safepoint_Stats::print_at_exit = false;
+
+
+Safepoint_Stats* Safepoint_Stats::create() {
+  return (Safepoint_Stats*)Memory_Semantics::shared_calloc(1, sizeof(Safepoint_Stats));
+}
+
+
+// Reasons are string literals; compare contents too, since one may be in several object files.
+Safepoint_Stats::Reason* Safepoint_Stats::reason_for(const char* why) {
+  for (int i = 0;  i < reason_count;  ++i)
+    if (reasons[i].why == why  ||  strcmp(reasons[i].why, why) == 0)
+      return &reasons[i];
+  if (reason_count == max_reasons) {
+    ++overflowed;
+    return NULL;
+  }
+  Reason* r = &reasons[reason_count];
+  r->why = why;
+  OS_Interface::mem_fence(); // readers may look at the entries below reason_count at any time
+  ++reason_count;
+  return r;
+}
+
+
+int Safepoint_Stats::bucket_for(u_int64 nsecs) {
+  int b = 0;
+  while ((nsecs >>= 1) != 0  &&  b < bucket_count - 1)
+    ++b;
+  return b;
+}
+
+
+void Safepoint_Stats::record_acquisition(const char* why, u_int64 arrival_nsecs, int laggard) {
+  Reason* r = reason_for(why);
+  if (r == NULL)  return;
+  ++r->count;
+  r->total_arrival_nsecs += arrival_nsecs;
+  r->max_arrival_nsecs = max(r->max_arrival_nsecs, arrival_nsecs);
+  ++r->arrival_histogram[bucket_for(arrival_nsecs)];
+  if (laggard >= 0  &&  laggard < Max_Number_Of_Cores)
+    ++r->last_to_arrive[laggard];
+}
+
+
+void Safepoint_Stats::record_release(const char* why, u_int64 hold_nsecs) {
+  Reason* r = reason_for(why);
+  if (r == NULL)  return;
+  r->total_hold_nsecs += hold_nsecs;
+  r->max_hold_nsecs = max(r->max_hold_nsecs, hold_nsecs);
+  ++r->hold_histogram[bucket_for(hold_nsecs)];
+}
+
+
+// Answers an Array with, for each reason:
+// {why. count. totalArrivalNanoseconds. maxArrivalNanoseconds. totalHoldNanoseconds. maxHoldNanoseconds.
+//  arrivalHistogram. holdHistogram. lastToArriveByRank}
+Oop Safepoint_Stats::get_stats() {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  int s = interp->makeArrayStart();
+  for (int i = 0;  i < reason_count;  ++i) {
+    Reason* r = &reasons[i];
+    int rs = interp->makeArrayStart();
+    PUSH_STRING_FOR_MAKE_ARRAY(r->why);
+    PUSH_POSITIVE_32_BIT_INT_FOR_MAKE_ARRAY(r->count);
+    PUSH_POSITIVE_64_BIT_INT_FOR_MAKE_ARRAY(r->total_arrival_nsecs);
+    PUSH_POSITIVE_64_BIT_INT_FOR_MAKE_ARRAY(r->max_arrival_nsecs);
+    PUSH_POSITIVE_64_BIT_INT_FOR_MAKE_ARRAY(r->total_hold_nsecs);
+    PUSH_POSITIVE_64_BIT_INT_FOR_MAKE_ARRAY(r->max_hold_nsecs);
+
+    int hs = interp->makeArrayStart();
+    for (int b = 0;  b < bucket_count;  ++b)
+      PUSH_POSITIVE_32_BIT_INT_FOR_MAKE_ARRAY(r->arrival_histogram[b]);
+    PUSH_FOR_MAKE_ARRAY(interp->makeArray(hs));
+
+    hs = interp->makeArrayStart();
+    for (int b = 0;  b < bucket_count;  ++b)
+      PUSH_POSITIVE_32_BIT_INT_FOR_MAKE_ARRAY(r->hold_histogram[b]);
+    PUSH_FOR_MAKE_ARRAY(interp->makeArray(hs));
+
+    int ls = interp->makeArrayStart();
+    FOR_ALL_RANKS(rank)
+      PUSH_POSITIVE_32_BIT_INT_FOR_MAKE_ARRAY(r->last_to_arrive[rank]);
+    PUSH_FOR_MAKE_ARRAY(interp->makeArray(ls));
+
+    PUSH_FOR_MAKE_ARRAY(interp->makeArray(rs));
+  }
+  return interp->makeArray(s);
+}
+
+
+// Keeps the reasons, so that readers without the safepoint never see one vanish.
+// Must hold the safepoint, like the other writers.
+void Safepoint_Stats::reset() {
+  for (int i = 0;  i < reason_count;  ++i) {
+    const char* why = reasons[i].why;
+    bzero(&reasons[i], sizeof(reasons[i]));
+    reasons[i].why = why;
+  }
+  overflowed = 0;
+}
+
+
+// Lower bound of the bucket holding the given percentile
+u_int64 Safepoint_Stats::percentile_of(const int* histogram, int count, int percent) {
+  int64 target = max(1LL, (int64)count * percent / 100),  part_sum = 0;
+  for (int b = 0;  b < bucket_count;  ++b) {
+    part_sum += histogram[b];
+    if (part_sum >= target)
+      return b == 0  ?  0  :  1ULL << b;
+  }
+  return 0;
+}
+
+
+void Safepoint_Stats::print() {
+  fprintf(stdout, "\n\nSafepoints (nanoseconds; percentiles are lower bounds of power-of-two buckets):\n");
+  fprintf(stdout, "reason\tcount\tmean arrival\t50%% arrival\t99%% arrival\tmax arrival"
+                  "\tmean hold\t50%% hold\t99%% hold\tmax hold\tslowest core\n");
+  for (int i = 0;  i < reason_count;  ++i) {
+    Reason* r = &reasons[i];
+    if (r->count == 0)  continue;
+    int slowest = -1;
+    FOR_ALL_RANKS(rank)
+      if (r->last_to_arrive[rank] > 0  &&  (slowest < 0  ||  r->last_to_arrive[rank] > r->last_to_arrive[slowest]))
+        slowest = rank;
+    fprintf(stdout, "%s\t%d\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t%llu\t",
+            r->why, r->count,
+            r->total_arrival_nsecs / r->count,
+            percentile_of(r->arrival_histogram, r->count, 50),
+            percentile_of(r->arrival_histogram, r->count, 99),
+            r->max_arrival_nsecs,
+            r->total_hold_nsecs / r->count,
+            percentile_of(r->hold_histogram, r->count, 50),
+            percentile_of(r->hold_histogram, r->count, 99),
+            r->max_hold_nsecs);
+    if (slowest < 0)  fprintf(stdout, "-\n");
+    else              fprintf(stdout, "%d (%d times)\n", slowest, r->last_to_arrive[slowest]);
+  }
+  if (overflowed)
+    fprintf(stdout, "%d safepoints for other reasons not recorded\n", overflowed);
+  fprintf(stdout, "\n");
+}
+
@@ -0,0 +1,60 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// Per-reason telemetry for Safepoint_for_moving_objects: how long the requester waited for the
+// other cores (time to safepoint), which core got there last, and how long it held them.
+// Shared; only the holder of the safepoint writes, so no locking. reset() writes the same
+// fields, so primitiveSafepointStatistics resets them while holding a safepoint, too.
+// Times are monotonic_nsecs, which need no Count_Cycles.
+// Histogram bucket i counts times of 2^i up to 2^(i+1) nanoseconds.
+// The last core to arrive is approximate: it is the one the requester last saw still missing,
+// so if several arrive between two of its polls, any one of them may be counted.
+// See primitiveSafepointStatistics, and -safepoint_stats to print them at quit.
+
+class Safepoint_Stats {
+public:
+  static bool print_at_exit; // threadsafe readonly config value
+
+  static const int max_reasons = 24;
+  static const int bucket_count = 40;
+
+private:
+  struct Reason {
+    const char* why;
+    int     count;
+    u_int64 total_arrival_nsecs, max_arrival_nsecs;
+    u_int64 total_hold_nsecs,    max_hold_nsecs;
+    int     arrival_histogram[bucket_count];
+    int     hold_histogram[bucket_count];
+    int     last_to_arrive[Max_Number_Of_Cores];
+  };
+  Reason reasons[max_reasons];
+  int    reason_count;
+  int    overflowed; // safepoints whose reason did not fit
+
+  Reason* reason_for(const char* why);
+  static int bucket_for(u_int64 nsecs);
+  static u_int64 percentile_of(const int* histogram, int count, int percent);
+
+public:
+  static Safepoint_Stats* create();
+
+  void record_acquisition(const char* why, u_int64 arrival_nsecs, int laggard_or_minus_one);
+  void record_release(const char* why, u_int64 hold_nsecs);
+
+  Oop get_stats();
+  void reset();
+  void print();
+};
+
@@ -0,0 +1,347 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+#include  <string>
+#include  <map> // before utils.h defines min and max
+
+#include "headers.h"
+
+# if On_Intel_Linux  &&  Using_Threads
+# include <time.h>
+# include <sys/syscall.h>
+# ifndef sigev_notify_thread_id
+#   define sigev_notify_thread_id _sigev_un._tid
+# endif
+# endif
+
+char* Sampling_Profiler::file_name = NULL;
+int   Sampling_Profiler::period_usecs = 0;
+Sampling_Profiler* Sampling_Profiler::profilers[Max_Number_Of_Cores];
+
+
+struct Sampling_Profiler::Tables {
+  std::map<std::string, int> folded_stacks;
+  std::map<std::pair<int, std::pair<int, bool> >, std::string> frame_names;
+};
+
+
+Sampling_Profiler::Sampling_Profiler(int r) {
+  head = tail = 0;
+  rank = r;
+  lock_word = 0;
+  lost_samples = 0;
+  tid = 0;
+  timer = NULL;
+  tables = new Tables();
+}
+
+
+// Called by each core's thread as it starts interpreting.
+void Sampling_Profiler::start_here() {
+  if (!is_supported()  ||  here() != NULL)
+    return;
+  Sampling_Profiler* sp = new Sampling_Profiler(Logical_Core::my_rank());
+# if On_Intel_Linux  &&  Using_Threads
+  sp->tid = syscall(SYS_gettid);
+  sp->thread = pthread_self();
+
+  // Cores starting together may each install the handler; the same one, so that does no harm.
+  static bool installed = false;
+  if (!installed) {
+    installed = true;
+    struct sigaction sa;
+    bzero(&sa, sizeof(sa));
+    sa.sa_handler = handle_signal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL) != 0)
+      perror("Sampling_Profiler sigaction");
+  }
+  if (file_name != NULL  &&  period_usecs == 0)
+    period_usecs = default_period_usecs;
+# endif
+  sp->lock();
+  if (period_usecs > 0)
+    sp->start(period_usecs);
+  sp->unlock();
+  OS_Interface::mem_fence();
+  profilers[sp->rank] = sp;
+}
+
+
+void Sampling_Profiler::set_period_everywhere(int usecs) {
+  period_usecs = usecs;
+  OS_Interface::mem_fence();
+  FOR_ALL_RANKS(r) {
+    Sampling_Profiler* sp = profilers[r];
+    if (sp == NULL)  continue;
+    sp->lock();
+    sp->stop();
+    if (usecs > 0)
+      sp->start(usecs);
+    sp->unlock();
+  }
+}
+
+
+// The timer runs on the owner's CPU time, so an idle or parked core takes no samples.
+void Sampling_Profiler::start(int usecs) {
+# if On_Intel_Linux  &&  Using_Threads
+  clockid_t clock;
+  if (pthread_getcpuclockid(thread, &clock) != 0) {
+    lprintf("Sampling_Profiler: no CPU clock for the thread of core %d\n", rank);
+    return;
+  }
+  struct sigevent sev;
+  bzero(&sev, sizeof(sev));
+  sev.sigev_notify = SIGEV_THREAD_ID;
+  sev.sigev_signo = SIGPROF;
+  sev.sigev_notify_thread_id = tid;
+  timer_t t;
+  if (timer_create(clock, &sev, &t) != 0) {
+    perror("Sampling_Profiler timer_create");
+    return;
+  }
+  struct itimerspec its;
+  its.it_interval.tv_sec  = its.it_value.tv_sec  =  usecs / 1000000;
+  its.it_interval.tv_nsec = its.it_value.tv_nsec = (usecs % 1000000) * 1000;
+  if (timer_settime(t, 0, &its, NULL) != 0) {
+    perror("Sampling_Profiler timer_settime");
+    timer_delete(t);
+    return;
+  }
+  timer = (void*)t;
+# endif
+}
+
+
+void Sampling_Profiler::stop() {
+# if On_Intel_Linux  &&  Using_Threads
+  if (timer != NULL)
+    timer_delete((timer_t)timer);
+# endif
+  timer = NULL;
+}
+
+
+void Sampling_Profiler::handle_signal(int) {
+  Squeak_Interpreter* const interp = The_Squeak_Interpreter();
+  Sampling_Profiler* const sp = profilers[interp->my_rank()];
+  if (sp != NULL)
+    sp->take_sample(interp);
+}
+
+
+// Runs in the signal handler, on the owner's thread: no allocation, no locks, no printing.
+// The interpreter may be anywhere, so every Oop is checked before it is followed.
+void Sampling_Profiler::take_sample(Squeak_Interpreter* interp) {
+  int h = head;
+  if (h - tail  >=  ring_size) {
+    ++lost_samples;
+    return;
+  }
+  Sample* s = &ring[h & (ring_size - 1)];
+  s->depth = 0;
+  s->block_mask = 0;
+  s->primitive_index = interp->running_primitive_index;
+
+  Safepoint_Tracker* const st = interp->safepoint_tracker;
+  if (st != NULL  &&  (st->am_spinning()  ||  st->is_every_other_core_safe()))
+    s->state = at_safepoint;
+  else if (!interp->process_is_scheduled_and_executing())
+    s->state = idle;
+  else {
+    s->state = interpreting;
+    Memory_System* const ms = The_Memory_System();
+    const Oop nil = interp->roots.nilObj;
+    Oop ctx = interp->roots._activeContext;
+    while (s->depth < max_depth  &&  ctx.is_mem()  &&  ctx != nil) {
+      Object_p co = ctx.as_object();
+      if (!ms->contains(co))
+        break;
+      bool is_block = co->is_this_context_a_block_context();
+      Oop home = is_block ? co->fetchPointer(Object_Indices::HomeIndex) : ctx;
+      if (!home.is_mem()  ||  !ms->contains(home.as_object()))
+        break;
+      s->methods[s->depth] = home.as_object()->fetchPointer(Object_Indices::MethodIndex);
+      s->classes[s->depth] = home.as_object()->fetchPointer(Object_Indices::ReceiverIndex).fetchClass();
+      if (is_block)
+        s->block_mask |= 1 << s->depth;
+      ++s->depth;
+      ctx = co->fetchPointer(Object_Indices::SenderIndex);
+    }
+  }
+  OS_Interface::mem_fence();
+  head = h + 1;
+  if (h + 1 - tail  >=  ring_size / 2)
+    interp->multicore_interrupt_check = true; // so the owner drains soon
+}
+
+
+void Sampling_Profiler::append(char* buf, int buf_size, const char* fmt, ...) {
+  int used = strlen(buf);
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(buf + used, buf_size - used, fmt, ap);
+  va_end(ap);
+}
+
+
+void Sampling_Profiler::append_class_name(Oop klass, char* buf, int buf_size) {
+  if (!klass.is_mem()  ||  !The_Memory_System()->contains(klass.as_object())) {
+    append(buf, buf_size, "?");
+    return;
+  }
+  bool is_meta;
+  Oop name = klass.as_object()->name_of_class_or_metaclass(&is_meta);
+  if (!name.is_mem())
+    append(buf, buf_size, "?");
+  else
+    append(buf, buf_size, "%.*s", name.as_object()->lengthOf(), name.as_object()->first_byte_address());
+  if (is_meta)
+    append(buf, buf_size, " class");
+}
+
+
+// "Foo>>bar", "Foo(Object)>>bar" when inherited, "[] in Foo>>bar" for a block
+void Sampling_Profiler::append_frame_name(Oop method, Oop klass, bool is_block, char* buf, int buf_size) {
+  Oop sel, mclass;
+  if (is_block)
+    append(buf, buf_size, "[] in ");
+  append_class_name(klass, buf, buf_size);
+  if (   klass.is_mem()  &&  The_Memory_System()->contains(klass.as_object())
+      && klass.as_object()->selector_and_class_of_method_in_me_or_ancestors(method, &sel, &mclass)) {
+    if (mclass != klass  &&  mclass != The_Squeak_Interpreter()->roots.nilObj) {
+      append(buf, buf_size, "(");
+      append_class_name(mclass, buf, buf_size);
+      append(buf, buf_size, ")");
+    }
+    if (sel.is_mem()  &&  sel != The_Squeak_Interpreter()->roots.nilObj)
+      append(buf, buf_size, ">>%.*s", sel.as_object()->lengthOf(), sel.as_object()->first_byte_address());
+    else
+      append(buf, buf_size, ">>?");
+  }
+  else
+    append(buf, buf_size, ">>?");
+}
+
+
+void Sampling_Profiler::append_frame(Oop method, Oop klass, bool is_block, char* buf, int buf_size) {
+  std::pair<int, std::pair<int, bool> > key(method.bits(), std::pair<int, bool>(klass.bits(), is_block));
+  std::string& name = tables->frame_names[key];
+  if (name.empty()) {
+    char b[256];
+    b[0] = '\0';
+    append_frame_name(method, klass, is_block, b, sizeof(b));
+    for (char* p = b;  *p;  ++p)
+      if (*p == ';')  *p = '_'; // separates frames
+    name = b;
+  }
+  append(buf, buf_size, ";%s", name.c_str());
+}
+
+
+void Sampling_Profiler::drain_locked() {
+  static const char* state_names[] = { "", ";<idle>", ";<safepoint>" };
+  for (int h = head;  tail != h;  ++tail) {
+    OS_Interface::mem_fence();
+    Sample* s = &ring[tail & (ring_size - 1)];
+    char buf[4096];
+    snprintf(buf, sizeof(buf), "core%d%s", rank, state_names[s->state]);
+    for (int i = s->depth - 1;  i >= 0;  --i)
+      append_frame(s->methods[i], s->classes[i], s->block_mask & (1 << i), buf, sizeof(buf));
+    if (s->primitive_index > 0)
+      append(buf, sizeof(buf), ";<prim %d>", s->primitive_index);
+    ++tables->folded_stacks[buf];
+  }
+}
+
+
+// Names are cached by Oop, and samples taken since the last drain hold Oops.
+void Sampling_Profiler::objects_have_moved() {
+  lock();
+  for (int h = head;  tail != h;  ++tail)
+    ++lost_samples;
+  tables->frame_names.clear();
+  unlock();
+}
+
+
+void Sampling_Profiler::append_folded_stacks(char** bufp, int* sizep, int* usedp, bool reset) {
+  std::string out;
+  char line[32];
+  for (std::map<std::string, int>::iterator i = tables->folded_stacks.begin();  i != tables->folded_stacks.end();  ++i) {
+    snprintf(line, sizeof(line), " %d\n", i->second);
+    out += i->first;
+    out += line;
+  }
+  if (lost_samples) {
+    snprintf(line, sizeof(line), "core%d;<lost> %d\n", rank, lost_samples);
+    out += line;
+  }
+  if (reset) {
+    tables->folded_stacks.clear();
+    lost_samples = 0;
+  }
+  if (*usedp + (int)out.size() + 1 > *sizep) {
+    *sizep = *usedp + out.size() + 1;
+    *bufp = (char*)realloc(*bufp, *sizep);
+  }
+  memcpy(*bufp + *usedp, out.c_str(), out.size() + 1);
+  *usedp += out.size();
+}
+
+
+// Caller holds a safepoint, so no owner is draining or moving objects.
+char* Sampling_Profiler::all_folded_stacks_as_malloced_string(bool reset) {
+  int size = 1, used = 0;
+  char* buf = (char*)malloc(size);
+  buf[0] = '\0';
+  FOR_ALL_RANKS(r) {
+    Sampling_Profiler* sp = profilers[r];
+    if (sp == NULL)  continue;
+    sp->lock();
+    sp->drain_locked();
+    sp->append_folded_stacks(&buf, &size, &used, reset);
+    sp->unlock();
+  }
+  return buf;
+}
+
+
+Oop Sampling_Profiler::sampled_stacks(bool reset) {
+  Safepoint_for_moving_objects sf("sampled_stacks");
+  char* s = all_folded_stacks_as_malloced_string(reset);
+  Oop r = Object::makeString(s)->as_oop();
+  free(s);
+  return r;
+}
+
+
+void Sampling_Profiler::write_file_if_requested() {
+  if (file_name == NULL  ||  !is_supported())
+    return;
+  Safepoint_for_moving_objects sf("write sampled stacks");
+  set_period_everywhere(0);
+  FILE* f = fopen(file_name, "w");
+  if (f == NULL) {
+    perror("sample profile file");
+    return;
+  }
+  char* s = all_folded_stacks_as_malloced_string(false);
+  fputs(s, f);
+  fclose(f);
+  free(s);
+}
+
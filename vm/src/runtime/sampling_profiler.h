@@ -0,0 +1,100 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// A sampling profiler that can be switched on and off while the VM runs, unlike Profiling_Tracer.
+// Each core's thread gets its own CPU-time timer, whose SIGPROF lands on that thread;
+// the handler records where the interpreter is (the method and receiver class of each context
+// up the sender chain, and the primitive running, if any) into that core's ring.
+// The handler only reads; samples are turned into names later, at points where objects
+// cannot have moved since: by the owner in multicore_interrupt when the ring fills up and
+// before a GC, and by whoever collects the profile, under a safepoint.
+// Counts are kept per folded stack ("core3;Foo>>bar;Foo>>baz;<prim 60> 17", root first),
+// the input flame graph tools expect.
+// Linux and threads only: the timers are per thread, and the collector reads every core's tables.
+
+class Sampling_Profiler {
+public:
+  static const int max_depth = 32;
+  static const int ring_size = 1024; // power of two
+  static const int default_period_usecs = 1000;
+  static char* file_name; // -sample_profile: profile from start, written here at quit
+
+  enum State { interpreting, idle, at_safepoint };
+
+private:
+  static Sampling_Profiler* profilers[Max_Number_Of_Cores]; // by rank, once the core is interpreting
+  static int period_usecs; // 0 when off
+
+  struct Sample {
+    int state;
+    int depth;
+    int primitive_index; // 0 if none running
+    u_int32 block_mask;  // bit i set if frame i is a block
+    Oop methods[max_depth]; // leaf first
+    Oop classes[max_depth];
+  };
+  Sample ring[ring_size];
+  volatile int head; // advanced only by the signal handler
+  int tail;          // advanced by the drainer, under the lock
+
+  int rank;
+  int lock_word;
+  int lost_samples;
+  int tid;
+  pthread_t thread;
+  void* timer; // timer_t, NULL when not running
+
+  struct Tables; // folded stack counts, and a cache of frame names till objects move
+  Tables* tables;
+
+  Sampling_Profiler(int rank);
+
+  void lock() {
+    while (!OS_Interface::atomic_compare_and_swap(&lock_word, 0, 1))
+      ;
+  }
+  void unlock() {
+    OS_Interface::mem_fence();
+    lock_word = 0;
+  }
+
+  void start(int period_usecs);
+  void stop();
+  void take_sample(Squeak_Interpreter*);
+  void drain_locked();
+  void append_frame(Oop method, Oop klass, bool is_block, char* buf, int buf_size);
+  void append_folded_stacks(char** bufp, int* sizep, int* usedp, bool reset);
+
+  static void handle_signal(int);
+  static char* all_folded_stacks_as_malloced_string(bool reset);
+
+public:
+  static bool is_supported() { return On_Intel_Linux  &&  Using_Threads; }
+  static Sampling_Profiler* here() { return profilers[Logical_Core::my_rank()]; }
+
+  static void start_here();
+  static void set_period_everywhere(int period_usecs);
+
+  bool needs_draining() { return head - tail  >=  ring_size / 2; }
+  void drain() { lock();  drain_locked();  unlock(); }
+  void objects_have_moved();
+
+  static void append(char* buf, int buf_size, const char* fmt, ...);
+  static void append_class_name(Oop klass, char* buf, int buf_size);
+  static void append_frame_name(Oop method, Oop klass, bool is_block, char* buf, int buf_size);
+
+  static Oop  sampled_stacks(bool reset);
+  static void write_file_if_requested();
+};
+
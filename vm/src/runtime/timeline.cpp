@@ -0,0 +1,125 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+#include "headers.h"
+# include <sys/time.h>
+
+char* Timeline::file_name = NULL;
+
+
+Timeline* Timeline::create() {
+  return (Timeline*)Memory_Semantics::shared_calloc(1, sizeof(Timeline));
+}
+
+
+u_int64 Timeline::now_usecs() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return u_int64(tv.tv_sec) * 1000000  +  tv.tv_usec;
+}
+
+
+void Timeline::add(char phase, Category c, const char* name, const char* detail, int id) {
+  Core_Events* ce = &cores[Logical_Core::my_rank()];
+  if (ce->events == NULL)
+    ce->events = (Event*)Memory_Semantics::shared_malloc(events_per_core * sizeof(Event));
+  if (ce->count == events_per_core) {
+    ++ce->dropped;
+    return;
+  }
+  Event* e = &ce->events[ce->count];
+  e->usecs = now_usecs();
+  e->name = name;
+  e->detail = detail;
+  e->id = id;
+  e->phase = phase;
+  e->category = c;
+  ++ce->count;
+}
+
+
+int Timeline::flow_start(Category c, const char* name) {
+  const int rank = Logical_Core::my_rank();
+  // unique across cores, and never 0
+  int id = (rank << 24)  |  (++cores[rank].next_flow_id & 0xffffff);
+  add('s', c, name, NULL, id);
+  return id;
+}
+
+
+void Timeline::print_string(FILE* f, const char* s) {
+  fputc('"', f);
+  for (;  *s;  ++s)
+    if (*s == '"'  ||  *s == '\\')  fprintf(f, "\\%c", *s);
+    else if ((u_char)*s < ' ')      fprintf(f, "\\u%04x", *s);
+    else                            fputc(*s, f);
+  fputc('"', f);
+}
+
+
+// Called at quit; reads the other cores' buffers as they are.
+void Timeline::write(const char* fn) {
+# define TIMELINE_CATEGORY_NAME(name) #name,
+  static const char* category_names[] = { FOR_ALL_TIMELINE_CATEGORIES_DO(TIMELINE_CATEGORY_NAME) };
+# undef TIMELINE_CATEGORY_NAME
+
+  FILE* f = fopen(fn, "w");
+  if (f == NULL) {
+    perror("timeline file");
+    return;
+  }
+  fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+  bool first = true;
+  FOR_ALL_RANKS(rank) {
+    Core_Events* ce = &cores[rank];
+    if (ce->events == NULL)
+      continue;
+    fprintf(f, "%s{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"core %d",
+            first ? "" : ",\n", rank, rank);
+    if (ce->dropped)
+      fprintf(f, ", %d events dropped", ce->dropped);
+    fprintf(f, "\"}}");
+    first = false;
+
+    for (int i = 0;  i < ce->count;  ++i) {
+      Event* e = &ce->events[i];
+      fprintf(f, ",\n{\"ph\": \"%c\", \"cat\": \"%s\", \"name\": ", e->phase, category_names[e->category]);
+      print_string(f, e->name);
+      fprintf(f, ", \"pid\": 1, \"tid\": %d, \"ts\": %llu", rank, e->usecs);
+      switch (e->phase) {
+        case 'i': fprintf(f, ", \"s\": \"t\"");                      break;
+        case 's': fprintf(f, ", \"id\": %d", e->id);                 break;
+        case 'f': fprintf(f, ", \"id\": %d, \"bp\": \"e\"", e->id);  break;
+      }
+      if (e->detail != NULL) {
+        fprintf(f, ", \"args\": {\"detail\": ");
+        print_string(f, e->detail);
+        fprintf(f, "}");
+      }
+      fprintf(f, "}");
+    }
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+}
+
+
+Timeline_Slice::Timeline_Slice(Timeline::Category c, const char* n, const char* detail) {
+  timeline = The_Squeak_Interpreter()->timeline;
+  category = c;
+  name = n;
+  if (timeline != NULL)
+    timeline->begin(c, n, detail);
+}
+
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+// A timeline of VM events, one track per core, written at quit in the Chrome trace JSON format
+// (load it in chrome://tracing or ui.perfetto.dev): GC phases, safepoint requests, holds and waits,
+// process switches, remote primitives, moving mutated read-mostly objects, and every message
+// between cores, drawn as an arrow from its send to its handling.
+// Each core appends only to its own buffer, allocated on its first event; once full,
+// further events of that core are counted and dropped. Times are gettimeofday microseconds,
+// since get_cycle_count is not always on.
+// Shared, NULL unless -timeline. -- see Squeak_Interpreter::timeline
+
+class Timeline {
+public:
+  static char* file_name; // -timeline
+  static const int events_per_core = 1 << 18;
+
+# define FOR_ALL_TIMELINE_CATEGORIES_DO(template) \
+  template(gc) \
+  template(safepoint) \
+  template(scheduler) \
+  template(primitive) \
+  template(message) \
+  template(replication)
+
+# define DEFINE_TIMELINE_CATEGORY(name) name,
+  enum Category { FOR_ALL_TIMELINE_CATEGORIES_DO(DEFINE_TIMELINE_CATEGORY) category_count };
+# undef DEFINE_TIMELINE_CATEGORY
+
+private:
+  struct Event {
+    u_int64 usecs;
+    const char* name;
+    const char* detail; // NULL or shown as args.detail
+    int  id;            // of the flow, for flow events
+    char phase;         // 'B'egin, 'E'nd, 'i'nstant, flow 's'tart or 'f'inish
+    char category;
+  };
+  struct Core_Events {
+    Event* events;
+    int count;
+    int dropped;
+    int next_flow_id;
+  } __attribute__((aligned(64)));
+  Core_Events cores[Max_Number_Of_Cores];
+
+  void add(char phase, Category c, const char* name, const char* detail, int id);
+  static u_int64 now_usecs();
+  static void print_string(FILE*, const char*);
+
+public:
+  static Timeline* create();
+
+  void begin(Category c, const char* name, const char* detail = NULL) { add('B', c, name, detail, 0); }
+  void end(Category c, const char* name)                               { add('E', c, name, NULL, 0); }
+  void instant(Category c, const char* name, const char* detail = NULL) { add('i', c, name, detail, 0); }
+  int  flow_start(Category c, const char* name);
+  void flow_finish(Category c, const char* name, int id) { if (id != 0)  add('f', c, name, NULL, id); }
+
+  void write(const char* file_name);
+};
+
+
+// A slice on this core's track for the life of the scope, if there is a timeline.
+class Timeline_Slice {
+  Timeline* timeline;
+  Timeline::Category category;
+  const char* name;
+public:
+  Timeline_Slice(Timeline::Category c, const char* n, const char* detail = NULL);
+  ~Timeline_Slice() { if (timeline != NULL)  timeline->end(category, name); }
+};
+
@@ -48,6 +48,18 @@ void print_time() {
   fprintf(stderr, "%s", ctime(&tv.tv_sec));
 }
 
+u_int64 monotonic_nsecs() {
+# if On_Apple
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return u_int64(tv.tv_sec) * 1000000000LL  +  u_int64(tv.tv_usec) * 1000;
+# else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return u_int64(ts.tv_sec) * 1000000000LL  +  ts.tv_nsec;
+# endif
+}
+
 int least_significant_bit_position(u_int64 x) {
   for (int i = 0;  i < 64;  ++i, (x >>= 1))
     if (x & 1) return i;
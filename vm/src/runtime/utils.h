@@ -84,6 +84,7 @@ int log_of_power_of_two(int);
 int least_significant_bit_position(u_int64);
 
 void print_time();
+u_int64 monotonic_nsecs(); // unlike OS_Interface::get_cycle_count, works without Count_Cycles
 
 
 extern "C" void lprintf(const char* msg, ...);
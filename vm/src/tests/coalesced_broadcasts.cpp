@@ -0,0 +1,61 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ *
+ *  Contributors:
+ *    David Ungar, IBM Research - Initial Implementation
+ *    Sam Adams, IBM Research - Initial Implementation
+ *    Stefan Marr, Vrije Universiteit Brussel - Port to x86 Multi-Core Systems
+ ******************************************************************************/
+
+
+# include <gtest/gtest.h>
+
+# include "headers.h"
+
+// Cores 1 and 2 broadcast to core 0; no messages are sent, the tests play the senders.
+
+TEST(CoalescedBroadcasts, schedulerOwesNothing) {
+  Coalesced_Broadcasts* cb = Coalesced_Broadcasts::create();
+  bool must_schedule;
+
+  ASSERT_TRUE(cb->add_datum_from(1, 0, sizeof(int), 8, 7, &must_schedule));
+  ASSERT_TRUE(must_schedule);
+  ASSERT_TRUE(cb->add_datum_from(1, 0, sizeof(int), 8, 9, &must_schedule));
+  ASSERT_FALSE(must_schedule);
+
+  // its own applyPendingBroadcastsMessage is ahead of anything else it sends
+  ASSERT_FALSE(cb->take_owed_apply(1, 0));
+}
+
+TEST(CoalescedBroadcasts, joiningAnotherSendersBatchOwesAnApply) {
+  Coalesced_Broadcasts* cb = Coalesced_Broadcasts::create();
+
+  ASSERT_TRUE (cb->add_flush_from(1, 0, Oop::from_int(3), false, false));
+  ASSERT_FALSE(cb->add_flush_from(2, 0, Oop::from_int(4), false, false));
+
+  // core 1's message may be handled after core 2's next one, so core 2 sends its own first
+  ASSERT_TRUE (cb->take_owed_apply(2, 0));
+  ASSERT_FALSE(cb->take_owed_apply(2, 0));
+  ASSERT_FALSE(cb->take_owed_apply(1, 0));
+}
+
+TEST(CoalescedBroadcasts, fullBatchKeepsSenderOrder) {
+  Coalesced_Broadcasts* cb = Coalesced_Broadcasts::create();
+  bool must_schedule;
+
+  for (int i = 0;  i < Coalesced_Broadcasts::max_data;  ++i)
+    ASSERT_TRUE(cb->add_datum_from(1, 0, sizeof(int), i * sizeof(int), i, &must_schedule));
+
+  // core 2's first datum goes into the full batch...
+  ASSERT_TRUE(cb->add_datum_from(2, 0, sizeof(int), 0, 42, &must_schedule));
+  ASSERT_FALSE(must_schedule);
+
+  // ...and its second does not fit, so it is sent directly,
+  // which must come after an apply of the batch
+  ASSERT_FALSE(cb->add_datum_from(2, 0, sizeof(int), Coalesced_Broadcasts::max_data * sizeof(int), 43, &must_schedule));
+  ASSERT_TRUE(cb->take_owed_apply(2, 0));
+}
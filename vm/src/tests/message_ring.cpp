@@ -0,0 +1,117 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ * 
+ *  Contributors:
+ *    Stefan Marr, Vrije Universiteit Brussel - Initial Implementation
+ ******************************************************************************/
+
+
+# if !On_Tilera
+
+#include <gtest/gtest.h>
+#include "message_ring.h"
+
+TEST(MessageRingTest, hasData) {
+  char sampleData[10] = { 3, 5, 4, 88, 66, 77, 22, 44, 45, 11 };
+  MessageRing ring(1024);
+
+  EXPECT_FALSE(ring.hasData());
+
+  ring.send(sampleData, 10);
+
+  EXPECT_TRUE(ring.hasData());
+}
+
+TEST(MessageRingTest, releaseOldest) {
+  char sampleData[10] = { 3, 5, 4, 88, 66, 77, 22, 44, 45, 11 };
+  MessageRing ring(1024);
+  ring.send(sampleData, 10);
+
+  size_t size;
+  void* result = (void*)ring.receive(size);
+
+  EXPECT_FALSE(ring.hasData());
+
+  ring.releaseOldest(result);
+
+  EXPECT_FALSE(ring.hasData());
+}
+
+TEST(MessageRingTest, simpleSend) {
+  char sampleData[10] = { 3, 5, 4, 88, 66, 77, 22, 44, 45, 11 };
+  const char* receiveBuffer = NULL;
+
+  MessageRing ring(1024);
+  ring.send(sampleData, 10);
+
+  size_t size;
+  receiveBuffer = (const char*)ring.receive(size);
+
+  EXPECT_NE((intptr_t)NULL, (intptr_t)receiveBuffer);
+  EXPECT_EQ(10, size);
+
+  for (size_t i = 0; i < size; i++) {
+    EXPECT_EQ(sampleData[i], receiveBuffer[i]);
+  }
+}
+
+TEST(MessageRingTest, keepsOrderOfVariableSizes) {
+  MessageRing ring(1024);
+  char data[40];
+
+  for (int i = 1; i <= 4; i++) {
+    memset(data, i, sizeof(data));
+    ring.send(data, i * 10);
+  }
+
+  for (int i = 1; i <= 4; i++) {
+    size_t size;
+    const char* msg = (const char*)ring.receive(size);
+    EXPECT_EQ(i * 10, size);
+    EXPECT_EQ(i, msg[0]);
+    EXPECT_EQ(i, msg[size - 1]);
+    ring.releaseOldest((void*)msg);
+  }
+  EXPECT_FALSE(ring.hasData());
+}
+
+TEST(MessageRingTest, wrapsAround) {
+  // 24 byte records do not divide 256, so some get split into skips at the end
+  MessageRing ring(256);
+
+  for (int32_t i = 0; i < 1000; i++) {
+    int32_t data[4] = { i, i + 1, i + 2, i + 3 };
+    ring.send(data, sizeof(data));
+
+    size_t size;
+    const int32_t* msg = (const int32_t*)ring.receive(size);
+    EXPECT_EQ(sizeof(data), size);
+    EXPECT_EQ(i,     msg[0]);
+    EXPECT_EQ(i + 3, msg[3]);
+    ring.releaseOldest((void*)msg);
+  }
+  EXPECT_FALSE(ring.hasData());
+}
+
+TEST(MessageRingTest, holdsSeveralReceivedMessages) {
+  MessageRing ring(1024);
+  int32_t a = 1, b = 2;
+  ring.send(&a, sizeof(a));
+  ring.send(&b, sizeof(b));
+
+  size_t size;
+  const int32_t* first  = (const int32_t*)ring.receive(size);
+  const int32_t* second = (const int32_t*)ring.receive(size);
+  EXPECT_EQ(1, *first);
+  EXPECT_EQ(2, *second);
+
+  ring.releaseOldest((void*)first);
+  ring.releaseOldest((void*)second);
+  EXPECT_FALSE(ring.hasData());
+}
+
+# endif // !On_Tilera
@@ -0,0 +1,154 @@
+/******************************************************************************
+ *  Copyright (c) 2008 - 2010 IBM Corporation and others.
+ *  All rights reserved. This program and the accompanying materials
+ *  are made available under the terms of the Eclipse Public License v1.0
+ *  which accompanies this distribution, and is available at
+ *  http://www.eclipse.org/legal/epl-v10.html
+ * 
+ *  Contributors:
+ *    Stefan Marr, Vrije Universiteit Brussel - Initial Implementation
+ ******************************************************************************/
+
+
+# if !On_Tilera
+
+#include <gtest/gtest.h>
+#include <limits.h>
+#include <sys/time.h>
+
+#include "message_ring.h"
+#include "synced_queue.h"
+#include "starter.h"
+
+/**
+ * Several producers, one consumer, as for the messages to one core.
+ * The Throughput tests are microbenchmarks, comparing the MessageRing with
+ * the syncedqueue (see synced_queue_threaded.cpp) that BufferedChannel is built on;
+ * run them with --gtest_also_run_disabled_tests --gtest_filter=*Throughput*
+ */
+
+static const int     RING_PRODUCERS = 3;
+static const int64_t RING_ITEMS     = 200000;
+static const int     MESSAGE_WORDS  = 16; // about an abstractMessage_class
+
+static MessageRing* ring;
+static syncedqueue  ring_sq = { 0 };
+
+
+static double seconds_since(struct timeval* start) {
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  return (now.tv_sec - start->tv_sec)  +  (now.tv_usec - start->tv_usec) / 1e6;
+}
+
+
+static void _ringProducerThread(thread_param_t* const tp) {
+  thread_param_signalAndAwaitInitialization(tp);
+
+  int32_t msg[MESSAGE_WORDS];
+  for (int64_t i = 0; i < RING_ITEMS; i++) {
+    msg[0] = tp->id;
+    msg[1] = (int32_t)i;
+    // vary the size, to exercise the skips at the end of the ring
+    ring->send(msg, sizeof(int32_t) * (2 + i % (MESSAGE_WORDS - 1)));
+  }
+}
+
+static void _syncedQueueProducerThread(thread_param_t* const tp) {
+  thread_param_signalAndAwaitInitialization(tp);
+
+  int32_t msg[MESSAGE_WORDS];
+  for (int64_t i = 0; i < RING_ITEMS; i++) {
+    msg[0] = tp->id;
+    msg[1] = (int32_t)i;
+    syncedqueue_enqueue(&ring_sq, msg, MESSAGE_WORDS);
+  }
+}
+
+
+static starter_t starter; // the producers keep using it
+
+static void _startProducers(void (*func)(thread_param_t*), pthread_t* threads) {
+  starter_init(&starter, RING_PRODUCERS);
+  starter_spawn_threads(&starter, func, threads);
+  starter_signal_initalization_finished(&starter);
+}
+
+static void _joinProducers(pthread_t* threads) {
+  for (int i = 0; i < RING_PRODUCERS; i++)
+    pthread_join(threads[i], NULL);
+}
+
+
+static void _consumeFromRing() {
+  int64_t next[RING_PRODUCERS] = { 0 };
+
+  for (int64_t remaining = RING_ITEMS * RING_PRODUCERS; remaining > 0; remaining--) {
+    size_t size;
+    const int32_t* msg = (const int32_t*)ring->receive(size);
+
+    // each producer's messages come in order, complete
+    ASSERT_LT(msg[0], RING_PRODUCERS);
+    ASSERT_EQ(next[msg[0]], msg[1]);
+    ASSERT_EQ(sizeof(int32_t) * (2 + msg[1] % (MESSAGE_WORDS - 1)), size);
+    next[msg[0]]++;
+
+    ring->releaseOldest((void*)msg);
+  }
+  EXPECT_FALSE(ring->hasData());
+}
+
+
+TEST(MessageRingThreaded, Pressure) {
+  ring = new MessageRing(4096); // small, so that it fills up and wraps often
+  pthread_t threads[RING_PRODUCERS];
+
+  _startProducers(_ringProducerThread, threads);
+  _consumeFromRing();
+  _joinProducers(threads);
+
+  delete ring;
+}
+
+
+TEST(MessageRingThreaded, DISABLED_Throughput) {
+  ring = new MessageRing(1 << 18);
+  pthread_t threads[RING_PRODUCERS];
+  struct timeval start;
+  gettimeofday(&start, NULL);
+
+  _startProducers(_ringProducerThread, threads);
+  _consumeFromRing();
+  _joinProducers(threads);
+
+  double secs = seconds_since(&start);
+  printf("MessageRing: %d producers, %.0f messages/s\n",
+         RING_PRODUCERS, RING_ITEMS * RING_PRODUCERS / secs);
+  delete ring;
+}
+
+
+TEST(MessageRingThreaded, DISABLED_SyncedQueueThroughput) {
+  // the same number of words in flight as the ring above
+  const int buf_size = (USHRT_MAX / MESSAGE_WORDS) * MESSAGE_WORDS;
+  int32_t* buffer = new int32_t[buf_size];
+  syncedqueue_initialize(&ring_sq, buffer, buf_size);
+  pthread_t threads[RING_PRODUCERS];
+  struct timeval start;
+  gettimeofday(&start, NULL);
+
+  _startProducers(_syncedQueueProducerThread, threads);
+
+  int32_t msg[MESSAGE_WORDS];
+  for (int64_t remaining = RING_ITEMS * RING_PRODUCERS; remaining > 0; remaining--)
+    syncedqueue_dequeue(&ring_sq, msg, MESSAGE_WORDS);
+
+  _joinProducers(threads);
+
+  double secs = seconds_since(&start);
+  printf("syncedqueue: %d producers, %.0f messages/s\n",
+         RING_PRODUCERS, RING_ITEMS * RING_PRODUCERS / secs);
+  delete[] buffer;
+}
+
+# endif // !On_Tilera
@@ -178,6 +178,7 @@ void starter_spawn_threads(starter_t* const starter, void (*func)(thread_param_t
  */
 void starter_signal_initalization_finished(starter_t* const starter) {
   pthread_mutex_lock    (&starter->global_init_mtx);
+  starter->init_completed = true; // for threads that have not started waiting yet
   pthread_cond_broadcast(&starter->global_init_sig);
   pthread_mutex_unlock  (&starter->global_init_mtx);
 }
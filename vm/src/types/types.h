@@ -36,6 +36,7 @@ class Object;
 class Chunk;
 class Abstract_Mark_Sweep_Collector;
 class Squeak_Image_Reader;
+class Snapshot_Layout;
 class Squeak_Interpreter;
 
 class typedefs {
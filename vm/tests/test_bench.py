@@ -0,0 +1,36 @@
+from twisted.trial import unittest
+
+import subprocess
+import os
+import json
+import tempfile
+
+from test_startup import determine_launch_executable
+
+class BenchTest(unittest.TestCase):
+
+    image = os.path.dirname(__file__) + "/../src/from_squeak/iOS/vm/iPhone/iPhone.image"
+    rvm = determine_launch_executable()
+
+    def run_bench(self, expression, timeout):
+        (tmp, tmp_name) = tempfile.mkstemp()
+        os.close(tmp)
+        cmd = self.rvm + ["-headless", "-bench", expression,
+                          "-iterations", "3", "-warmup", "1",
+                          "-bench_timeout", str(timeout), "-bench_output", tmp_name,
+                          self.image]
+        exitcode = subprocess.call(cmd)
+        report = json.load(file(tmp_name))
+        os.remove(tmp_name)
+        return (exitcode, report, cmd)
+
+    def test_bench_expression(self):
+        (exitcode, report, cmd) = self.run_bench("3+4", 300)
+        self.assertEquals(0, exitcode, "Execution failed " + " ".join(cmd))
+        self.assertEquals("3+4", report["expression"])
+        self.assertEquals(3, len(report["iterations"]))
+
+    def test_bench_syntax_error_times_out(self):
+        (exitcode, report, cmd) = self.run_bench("3 +", 30)
+        self.assertNotEquals(0, exitcode, "Did not fail " + " ".join(cmd))
+        self.assertTrue("error" in report)